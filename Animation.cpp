@@ -0,0 +1,209 @@
+/*
+ *  This file is part of DisplayGroup Library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ */
+
+#include "Animation.h"
+#include "DisplayManager.h"
+
+namespace DisplayGroup {
+
+Animation::Animation(const byte codes[], uint16_t size, byte mode, boolean flash) :
+      codes(codes), size(size), mode(mode), flash(flash) {
+}
+
+uint16_t Animation::renderText(const char * text, const Font & font, byte codes[], uint16_t size) {
+  uint16_t count = 0;
+
+  for (; *text != '\0'; ++text) {
+    if (*text == '.' && count != 0) {
+      codes[count - 1] |= font.getCode('.');
+      continue;
+    }
+
+    if (count == size) {
+      break;
+    }
+
+    codes[count++] = font.getCode(*text);
+  }
+
+  return count;
+}
+
+uint16_t Animation::getFrameCount(byte width) const {
+  if (width == 0) {
+    return 0;
+  }
+
+  switch (mode) {
+  case SCROLL:
+    // From the first code on the rightmost display to the last one gone on the left
+    return size + width;
+  case MARQUEE:
+    return size;
+  default:
+    return size / width;
+  }
+}
+
+byte Animation::getCode(uint16_t frame, byte display, byte width) const {
+  uint16_t index;
+
+  switch (mode) {
+  case SCROLL:
+    // The strip moves left by one display each frame
+    index = frame + display + 1;
+
+    if (index < width) {
+      return 0;
+    }
+
+    index -= width;
+    break;
+  case MARQUEE:
+    index = frame + display;
+
+    while (index >= size && size != 0) {
+      index -= size;
+    }
+
+    break;
+  default:
+    index = frame * width + display;
+    break;
+  }
+
+  if (index >= size) {
+    return 0;
+  }
+
+  return flash ? pgm_read_byte(codes + index) : codes[index];
+}
+
+namespace {
+
+// No code: all the displays blank
+const Animation blank(NULL, 0);
+
+}
+
+Animator::Animator(DisplayManager & manager, byte id) :
+      _manager(manager), _id(id), _steps(NULL), _count(0), _step(0), _cycle(0), _frame(0), _ticks(0) {
+}
+
+void Animator::play(const AnimationStep steps[], byte count) {
+  _steps = steps;
+  _count = count;
+  _step = 0;
+  _cycle = 0;
+  _frame = 0;
+  _ticks = 0;
+}
+
+void Animator::stop() {
+  if (_steps) {
+    _steps = NULL;
+    _manager.showValue(_id);
+  }
+}
+
+boolean Animator::isPlaying() const {
+  return _steps != NULL;
+}
+
+boolean Animator::tick() {
+  if (!_steps) {
+    return false;
+  }
+
+  // Skip the steps with no frame, e.g. an animation too wide for the group
+  while (_step != _count && getFrameCount(_steps[_step]) == 0) {
+    ++_step;
+  }
+
+  if (_step == _count) {
+    stop();
+    return false;
+  }
+
+  const AnimationStep & step = _steps[_step];
+
+  // Written at every tick, the codes that did not change cost only the comparison
+  showFrame(step, _frame);
+
+  if (++_ticks < step.ticks) {
+    return true;
+  }
+
+  _ticks = 0;
+
+  if (++_frame == getFrameCount(step)) {
+    _frame = 0;
+
+    if (step.repeat != 0 && ++_cycle == step.repeat) {
+      _cycle = 0;
+      ++_step;
+    }
+  }
+
+  return true;
+}
+
+void Animator::showFrame(const AnimationStep & step, uint16_t frame) {
+  switch (step.effect) {
+  case BLANK:
+    _manager.showCodes(_id, blank, 0);
+    break;
+  case BLINK:
+    if (frame == 0) {
+      _manager.showCodes(_id, blank, 0);
+    } else {
+      _manager.showValue(_id);
+    }
+
+    break;
+  case PLAY:
+    _manager.showCodes(_id, *step.animation, frame);
+    break;
+  case FADE_IN:
+    _manager.showValue(_id);
+    _manager.setBrightness((frame + 1) * (255 / FADE_LEVELS));
+    break;
+  case FADE_OUT:
+    _manager.showValue(_id);
+    _manager.setBrightness(255 - (frame + 1) * (255 / FADE_LEVELS));
+    break;
+  default:
+    _manager.showValue(_id);
+    break;
+  }
+}
+
+uint16_t Animator::getFrameCount(const AnimationStep & step) const {
+  switch (step.effect) {
+  case BLINK:
+    return 2;
+  case PLAY:
+    return step.animation ? step.animation->getFrameCount(_manager.getDisplayNumber(_id)) : 0;
+  case FADE_IN:
+  case FADE_OUT:
+    return FADE_LEVELS;
+  default:
+    return 1;
+  }
+}
+
+} /* namespace DisplayGroup */
@@ -0,0 +1,205 @@
+/*
+ *  This file is part of DisplayGroup Library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ */
+
+#ifndef ANIMATION_H_
+#define ANIMATION_H_
+
+#include <Arduino.h>
+
+#include <Font.h>
+
+namespace DisplayGroup {
+
+class DisplayManager;
+
+/**
+ * @brief Precomputed 7-segments codes shown by a group instead of its value.
+ *
+ * The codes are in reading order, the leftmost display first, most significant bit
+ * first as in a Font, and they can be in flash (PROGMEM) when the animation is static.
+ * They are played in one of three modes, for a group of n displays:
+ * - Animation::FRAMES: the codes are a list of frames of n codes each
+ * - Animation::SCROLL: the codes are a strip, e.g. a message rendered by
+ *   Animation::renderText, that enters the group from the right and leaves it on the left
+ * - Animation::MARQUEE: the strip turns in the group without end, the last code followed
+ *   by the first one
+ */
+class Animation {
+public:
+
+  /**
+   * How the codes are played.
+   */
+  enum Mode {
+    FRAMES = 0,     /**< Frames of the width of the group */
+    SCROLL,         /**< Strip scrolled once from right to left */
+    MARQUEE         /**< Strip scrolled in a loop */
+  };
+
+  /**
+   * Constructor.
+   *
+   * @param[in] codes[]     The 7-segments codes, they must outlive the animation
+   * @param[in] size        Number of codes
+   * @param[in] mode        The Animation::Mode
+   * @param[in] flash       True if the codes are in flash (PROGMEM), false if in RAM
+   */
+  Animation(const byte codes[], uint16_t size, byte mode = FRAMES, boolean flash = false);
+
+  /**
+   * Render a text in a strip of codes, once, to scroll it without reading the font again.
+   * A '.' lights the decimal point of the previous character, as in a text group.
+   *
+   * @param[in]  text       The string to render
+   * @param[in]  font       The font of the characters
+   * @param[out] codes[]    The strip
+   * @param[in]  size       Size of the strip
+   * @return The number of codes written, the text is cut at the size of the strip
+   */
+  static uint16_t renderText(const char * text, const Font & font, byte codes[], uint16_t size);
+
+  /**
+   * @param[in] width       Number of displays of the group
+   * @return The number of frames of the animation in a group of that width
+   */
+  uint16_t getFrameCount(byte width) const;
+
+  /**
+   * @param[in] frame       The frame, less than Animation::getFrameCount
+   * @param[in] display     The display, 0 for the leftmost one
+   * @param[in] width       Number of displays of the group
+   * @return The 7-segments code of the display, most significant bit first, 0 (blank)
+   *         outside of the codes
+   */
+  byte getCode(uint16_t frame, byte display, byte width) const;
+
+  const byte * codes;     /**< The 7-segments codes */
+  uint16_t size;          /**< Number of codes */
+  byte mode;              /**< Animation::Mode */
+  boolean flash;          /**< True if the codes are in flash */
+};
+
+/**
+ * @brief One step of the sequence played by an Animator.
+ *
+ * A step shows its frames for a number of ticks each, and it is played a number of times,
+ * e.g. { Animator::BLINK, NULL, 25, 3 } flashes the group three times.
+ */
+struct AnimationStep {
+  byte effect;                    /**< Animator::Effect of the step */
+  const Animation * animation;    /**< Codes played by Animator::PLAY, NULL for the other effects */
+  byte ticks;                     /**< Ticks each frame is shown, at least 1 */
+  byte repeat;                    /**< Number of times the step is played, 0 for ever */
+};
+
+/**
+ * @brief Sequencer of the animations of one group.
+ *
+ * The animator plays a sequence of AnimationStep on a group, advanced by a call to
+ * Animator::tick at a fixed rate, from the loop or after a timer expired. Each tick writes
+ * the frame in the frame buffer through DisplayManager::showCodes, which compares it with
+ * the codes on the displays: only when a byte differs the chain (or its segment) is shifted
+ * out by the next DisplayManager::updateAll or DisplayManager::commit, so holding a frame
+ * costs no shift at all.
+ * While the animator plays, the group does not show its value: a change of the value is
+ * rendered when the group is back to its value, with a hold or blink step or at the end
+ * of the sequence. The fade steps change the brightness of the whole manager, see
+ * DisplayManager::setBrightness, and they leave it as they end: they need a dimming pin,
+ * see DisplayManager::setDimmingPin, otherwise they only show the value.
+ *
+ * Not to be called from an interrupt.
+ */
+class Animator {
+public:
+
+  /**
+   * What a step shows.
+   */
+  enum Effect {
+    HOLD = 0,       /**< The value of the group, for one frame */
+    BLANK,          /**< All the segments off, for one frame */
+    BLINK,          /**< Blank and then the value, two frames */
+    PLAY,           /**< The frames of the Animation of the step */
+    FADE_IN,        /**< The brightness from off to full, Animator::FADE_LEVELS frames */
+    FADE_OUT        /**< The brightness from full to off, Animator::FADE_LEVELS frames */
+  };
+
+  static const byte FADE_LEVELS = 15;   /**< Number of frames of a fade */
+
+  /**
+   * Constructor.
+   *
+   * @param[in] manager     The manager of the group
+   * @param[in] id          Unique Id of the group
+   */
+  Animator(DisplayManager & manager, byte id);
+
+  /**
+   * Start a sequence, from its first step. The first frame is shown at the next tick.
+   *
+   * @param[in] steps[]     The steps, they must outlive the sequence
+   * @param[in] count       Number of steps
+   */
+  void play(const AnimationStep steps[], byte count);
+
+  /**
+   * Stop the sequence: the group is back to its value.
+   */
+  void stop();
+
+  /**
+   * @return True while a sequence is played
+   */
+  boolean isPlaying() const;
+
+  /**
+   * Show the frame of the current step, and move to the next frame when the frame has been
+   * shown for the ticks of the step. At the end of the sequence the animator stops.
+   *
+   * @return True while a sequence is played
+   */
+  boolean tick();
+
+private:
+
+  /**
+   * Show a frame of a step.
+   *
+   * @param[in] step        The step
+   * @param[in] frame       The frame of the step
+   */
+  void showFrame(const AnimationStep & step, uint16_t frame);
+
+  /**
+   * @param[in] step        The step
+   * @return The number of frames of the step
+   */
+  uint16_t getFrameCount(const AnimationStep & step) const;
+
+  DisplayManager & _manager;      /**< The manager of the group */
+  byte _id;                       /**< Unique Id of the group */
+  const AnimationStep * _steps;   /**< The sequence, NULL when stopped */
+  byte _count;                    /**< Number of steps */
+  byte _step;                     /**< Current step */
+  byte _cycle;                    /**< Number of times the current step has been played */
+  uint16_t _frame;                /**< Current frame of the step */
+  byte _ticks;                    /**< Ticks the current frame has been shown */
+};
+
+} /* namespace DisplayGroup */
+
+#endif /* ANIMATION_H_ */
@@ -0,0 +1,147 @@
+/*
+ *  This file is part of DisplayGroup Library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ */
+
+#include "Bcd.h"
+
+namespace DisplayGroup {
+
+/**
+ * Subtract pow from value as many times as possible.
+ *
+ * @param[in,out] value     The value, on return less than pow
+ * @param[in]     pow       The power of ten
+ * @return The number of subtractions, i.e. the decimal digit of pow
+ */
+static inline byte countPow(uint16_t & value, uint16_t pow) {
+  byte digit = 0;
+
+  while (value >= pow) {
+    value -= pow;
+    ++digit;
+  }
+
+  return digit;
+}
+
+/**
+ * Count the significant digits.
+ *
+ * @param[in] digits        The digits, the least significant first
+ * @param[in] size          Number of digits
+ * @return The number of digits up to the most significant non zero one, at least 1
+ */
+static inline byte countDigits(const byte digits[], byte size) {
+  while (size > 1 && digits[size - 1] == 0) {
+    --size;
+  }
+
+  return size;
+}
+
+/**
+ * Binary weighted subtraction of pow: 8, 4, 2 and 1 times, always four comparisons.
+ *
+ * @param[in,out] value     The value, less than 10 * pow; on return less than pow
+ * @param[in]     pow       The power of ten
+ * @return The decimal digit of pow
+ */
+static inline byte countPow32(uint32_t & value, uint32_t pow) {
+  byte digit = 0;
+
+  if (value >= pow << 3) {
+    value -= pow << 3;
+    digit = 8;
+  }
+
+  if (value >= pow << 2) {
+    value -= pow << 2;
+    digit += 4;
+  }
+
+  if (value >= pow << 1) {
+    value -= pow << 1;
+    digit += 2;
+  }
+
+  if (value >= pow) {
+    value -= pow;
+    ++digit;
+  }
+
+  return digit;
+}
+
+byte Bcd::convert(uint16_t value, byte digits[]) {
+  digits[4] = countPow(value, 10000);
+  digits[3] = countPow(value, 1000);
+  digits[2] = countPow(value, 100);
+  digits[1] = countPow(value, 10);
+  digits[0] = value;
+
+  return countDigits(digits, MAX_DIGITS_16);
+}
+
+byte Bcd::convert(uint8_t value, byte digits[]) {
+  byte digit = 0;
+
+  if (value >= 200) {
+    value -= 200;
+    digit = 2;
+  } else if (value >= 100) {
+    value -= 100;
+    digit = 1;
+  }
+
+  digits[2] = digit;
+
+  for (digit = 0; value >= 10; ++digit) {
+    value -= 10;
+  }
+
+  digits[1] = digit;
+  digits[0] = value;
+
+  return countDigits(digits, MAX_DIGITS_8);
+}
+
+byte Bcd::convert(uint32_t value, byte digits[]) {
+  // The most significant digit of a 32 bits value is at most 4
+  byte digit = 0;
+
+  while (value >= 1000000000UL) {
+    value -= 1000000000UL;
+    ++digit;
+  }
+
+  digits[9] = digit;
+  digits[8] = countPow32(value, 100000000UL);
+  digits[7] = countPow32(value, 10000000UL);
+  digits[6] = countPow32(value, 1000000UL);
+  digits[5] = countPow32(value, 100000UL);
+  digits[4] = countPow32(value, 10000UL);
+
+  // The rest is less than 10000: 16 bits conversion
+  uint16_t low = value;
+  digits[3] = countPow(low, 1000);
+  digits[2] = countPow(low, 100);
+  digits[1] = countPow(low, 10);
+  digits[0] = low;
+
+  return countDigits(digits, MAX_DIGITS_32);
+}
+
+} /* namespace DisplayGroup */
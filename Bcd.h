@@ -0,0 +1,76 @@
+/*
+ *  This file is part of DisplayGroup Library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ */
+
+#ifndef BCD_H_
+#define BCD_H_
+
+#include <Arduino.h>
+
+namespace DisplayGroup {
+
+/**
+ * @brief Binary to decimal digits conversion.
+ *
+ * The AVR CPUs have no division instruction, and every / 10 or % 10 is a call to a
+ * software division routine. This class extracts all the decimal digits of a value in
+ * one pass, subtracting the powers of ten from the most significant one: a 16 bits
+ * value takes at most 33 subtractions and no division at all.
+ * Each width has its own conversion: an 8 bits value never leaves the 8 bits registers,
+ * and a 32 bits value subtracts 8, 4, 2 and 1 times each power of ten, so every digit
+ * costs four 32 bits comparisons whatever its value.
+ */
+class Bcd {
+public:
+
+  static const byte MAX_DIGITS_8 = 3;    /**< Number of decimal digits of a 8 bits value */
+  static const byte MAX_DIGITS_16 = 5;   /**< Number of decimal digits of a 16 bits value */
+  static const byte MAX_DIGITS_32 = 10;  /**< Number of decimal digits of a 32 bits value */
+
+  /**
+   * Convert a value in decimal digits.
+   *
+   * @param[in]  value      The value to convert
+   * @param[out] digits     Array of Bcd::MAX_DIGITS_16 digits [0-9], the least significant
+   *                        first. The heading digits are filled with zeros.
+   * @return The number of significant digits of value, 1 for zero
+   */
+  static byte convert(uint16_t value, byte digits[]);
+
+  /**
+   * Convert a 8 bits value in decimal digits, see Bcd::convert.
+   *
+   * @param[in]  value      The value to convert
+   * @param[out] digits     Array of Bcd::MAX_DIGITS_8 digits [0-9], the least significant
+   *                        first
+   * @return The number of significant digits of value, 1 for zero
+   */
+  static byte convert(uint8_t value, byte digits[]);
+
+  /**
+   * Convert a 32 bits value in decimal digits, see Bcd::convert.
+   *
+   * @param[in]  value      The value to convert
+   * @param[out] digits     Array of Bcd::MAX_DIGITS_32 digits [0-9], the least significant
+   *                        first
+   * @return The number of significant digits of value, 1 for zero
+   */
+  static byte convert(uint32_t value, byte digits[]);
+};
+
+} /* namespace DisplayGroup */
+
+#endif /* BCD_H_ */
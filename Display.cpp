@@ -16,6 +16,7 @@
  */
 
 #include "Display.h"
+#include "DisplayManager.h"
 
 namespace DisplayGroup {
 
@@ -32,22 +33,16 @@ Display::Display(const byte digits[]) {
 Display::~Display() {
 }
 
-void Display::update(byte digit) const {
-  byte v = _digits[digit];
+byte Display::getCode(byte digit) const {
+  return _bitOrder == MSBFIRST ? _digits[digit] : DisplayManager::reverseBits(_digits[digit]);
+}
 
-  for (byte bitMask = 128; bitMask > 0; bitMask >>= 1) {
-    digitalWrite(DisplayManager::clockPin, LOW);
-    digitalWrite(DisplayManager::dataPin, v & bitMask ? HIGH : LOW);
-    digitalWrite(DisplayManager::clockPin, HIGH);
-  }
+void Display::update(ShiftTransport & transport, byte digit) const {
+  transport.write(getCode(digit));
 }
 
-void Display::turnOff() const {
-  for (byte bitMask = 128; bitMask > 0; bitMask >>= 1) {
-    digitalWrite(DisplayManager::clockPin, LOW);
-    digitalWrite(DisplayManager::dataPin,  LOW);
-    digitalWrite(DisplayManager::clockPin, HIGH);
-  }
+void Display::turnOff(ShiftTransport & transport) const {
+  transport.write(0);
 }
 
 byte Display::getBitOrder() const {
@@ -20,7 +20,7 @@
 
 #include <Arduino.h>
 
-#include <DisplayManager.h>
+#include <ShiftTransport.h>
 
 namespace DisplayGroup {
 
@@ -30,10 +30,11 @@ namespace DisplayGroup {
  * This class holds the representation of any digits within the single
  * 7-segment display. The class shifts out the data pin and manages
  * the clock pin to actually display the digits.
- * This class behave like an observer in the "Observer" GoF Design Pattern:
- * it observes the DisplayGroup to which belong and when its Display::update
- * method gets called the actual value to display is converted in binary form
- * and shifted out to the data output pin.
+ * When its Display::update method gets called the digit is converted in binary
+ * form and shifted out through the transport of the DisplayManager.
+ * A DisplayGroup does not hold Display objects: all the displays of a group
+ * share its array of digits codes, and their codes are rendered straight in the
+ * frame buffer of the DisplayManager.
  *
  * The shifting pattern follows the requirements for 74HC595 and 74HC164
  * shift register, which can be found in the datasheet.
@@ -58,19 +59,29 @@ public:
 
   /** Default Destructor
    */
-  virtual ~Display();
+  ~Display();
+
+  /**
+   * @param[in] digit       The digits to be displayed
+   * @return the 7-segments code of the digit, as shifted out by Display::update: most
+   *         significant bit first, bit reversed when the bit order is LSBFIRST
+   */
+  byte getCode(byte digit) const;
 
   /**
    * Shift out the binary value of update::digit using C bit masking
    *
+   * @param[in] transport   The transport of the chain, e.g. DisplayManager::getTransport
    * @param[in] digit	    The digits to be displayed
    */
-  void update(byte digit) const;
+  void update(ShiftTransport & transport, byte digit) const;
 
   /**
    * Shift out a binary zero (0) to turn off all the segments.
+   *
+   * @param[in] transport   The transport of the chain, e.g. DisplayManager::getTransport
    */
-  void turnOff() const;
+  void turnOff(ShiftTransport & transport) const;
 
   /**
    * @return the byte order of visualization: MSBFIRST or LSBFIRST
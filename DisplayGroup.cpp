@@ -16,82 +16,273 @@
  */
 
 #include "DisplayGroup.h"
+#include "DisplayManager.h"
 
 namespace DisplayGroup {
 
-DisplayGroup::DisplayGroup(byte nDisplay, byte id, uint16_t * value, const byte digits[]) :
-      _id(id), _nDisplay(nDisplay) {
+Sequence::Sequence() :
+      _count(0) {
+}
+
+void Sequence::bump() {
+  _count = _count + 1;
+}
+
+byte Sequence::read() const {
+  return _count;
+}
+
+Value::Value(const uint16_t * value, byte decimals) :
+      address(value), type(UINT16), decimals(decimals), pushed(false) {
+}
+
+Value::Value(const uint8_t * value, byte decimals) :
+      address(value), type(UINT8), decimals(decimals), pushed(false) {
+}
+
+Value::Value(const uint32_t * value, byte decimals) :
+      address(value), type(UINT32), decimals(decimals), pushed(false) {
+}
+
+Value::Value(const int8_t * value, byte decimals) :
+      address(value), type(INT8), decimals(decimals), pushed(false) {
+}
+
+Value::Value(const int16_t * value, byte decimals) :
+      address(value), type(INT16), decimals(decimals), pushed(false) {
+}
 
-  Display dis(digits);
-  _displays.assign(nDisplay, dis);
+Value::Value(const int32_t * value, byte decimals) :
+      address(value), type(INT32), decimals(decimals), pushed(false) {
+}
 
+Value::Value(const char * text) :
+      address(text), type(TEXT), decimals(0), pushed(false) {
+}
+
+Value::Value(Type type, byte decimals) :
+      address(NULL), type(type == TEXT ? INT32 : type), decimals(decimals), pushed(true) {
+}
+
+DisplayGroup::DisplayGroup(byte nDisplay, byte id, const Value & value, const Font & font) :
+      _font(font), _id(id), _nDisplay(nDisplay) {
+
+  _render = NULL;
+  _value = value.address;
+  _type = value.type;
+  _decimals = value.decimals;
+  _enabled = true;
+  _animation = NULL;
+  _animationFrame = 0;
+  _sequence = NULL;
+  _pushed = value.pushed;
+  _offset = 0;
+  _counterMode = COUNTER_OVERFLOW;
+  _clockTime = 0;
+  _bitOrder = DisplayManager::DEF_ORDER;
+  _chain = 0;
+
+  _lastValue = 0;
+  _lastBitOrder = _bitOrder;
+  _lastEnabled = _enabled;
+  _rendered = false;
+  _result = 0;
+
+  buildDigitCodes();
+  setSymbols(DisplayManager::DEF_MINUS, DisplayManager::DEF_POINT);
+}
+
+DisplayGroup::DisplayGroup(byte nDisplay, byte id, uint16_t * value, const Font & font, RenderFunction render) :
+      _font(font), _id(id), _nDisplay(nDisplay) {
+
+  _render = render;
   _value = value;
+  _type = Value::UINT16;
+  _decimals = 0;
   _enabled = true;
+  _animation = NULL;
+  _animationFrame = 0;
+  _sequence = NULL;
+  _pushed = false;
+  _offset = 0;
+  _counterMode = COUNTER_OVERFLOW;
+  _clockTime = 0;
   _bitOrder = DisplayManager::DEF_ORDER;
+  _chain = 0;
+
+  _lastValue = 0;
+  _lastBitOrder = _bitOrder;
+  _lastEnabled = _enabled;
+  _rendered = false;
+  _result = 0;
+
+  buildDigitCodes();
+  setSymbols(DisplayManager::DEF_MINUS, DisplayManager::DEF_POINT);
 }
 
 DisplayGroup::~DisplayGroup() {
 
 }
 
-int DisplayGroup::update() const {
+int DisplayGroup::render(byte * frame) {
+  // The animation keeps its codes when the whole frame is rendered again
+  if (_animation) {
+    _rendered = true;
+    _lastEnabled = _enabled;
+    _lastBitOrder = _bitOrder;
+
+    renderAnimation(frame);
+    _result = 0;
+    return _result;
+  }
+
+  return renderSnapshot(frame, _enabled && _value ? readValue() : _lastValue);
+}
+
+boolean DisplayGroup::renderChanged(byte * frame) {
+  // An animated group changes only when it is enabled or disabled
+  if (_animation) {
+    if (_enabled == _lastEnabled) {
+      return false;
+    }
+
+    render(frame);
+    return true;
+  }
+
+  // Read the watched value only once: the snapshot compared is the one rendered
+  uint32_t value = _enabled && _value ? readValue() : _lastValue;
+
+  if (_rendered && _enabled == _lastEnabled && _bitOrder == _lastBitOrder
+      && (_type == Value::TEXT || value == _lastValue)) {
+    return false;
+  }
+
+  renderSnapshot(frame, value);
+  return true;
+}
+
+int DisplayGroup::renderSnapshot(byte * frame, uint32_t value) {
+  _rendered = true;
+  _lastEnabled = _enabled;
+  _lastBitOrder = _bitOrder;
+
+  if (_enabled && _value) {
+    _lastValue = value;
+  }
+
+  _result = renderValue(frame, _lastValue);
+  return _result;
+}
+
+boolean DisplayGroup::isChanged() const {
+  if (_animation) {
+    return _enabled != _lastEnabled;
+  }
+
+  if (!_rendered || _enabled != _lastEnabled || _bitOrder != _lastBitOrder) {
+    return true;
+  }
+
+  // A text changes through DisplayGroup::setText only
+  return _enabled && _value && _type != Value::TEXT && readValue() != _lastValue;
+}
+
+uint32_t DisplayGroup::readValue() const {
+  if (!_sequence) {
+    return readVariable();
+  }
+
+  // Read again if an interrupt wrote the value in the meantime
+  byte sequence;
+  uint32_t value;
+
+  do {
+    sequence = _sequence->read();
+    value = readVariable();
+  } while (_sequence->read() != sequence);
+
+  return value;
+}
+
+uint32_t DisplayGroup::readVariable() const {
+  // Volatile reads: the value is read from memory at every call, in the order of the
+  // reads of the sequence counter
+  switch (_type) {
+  case Value::UINT16:
+    return *static_cast<const volatile uint16_t *>(_value);
+  case Value::UINT8:
+    return *static_cast<const volatile uint8_t *>(_value);
+  case Value::UINT32:
+    return *static_cast<const volatile uint32_t *>(_value);
+  case Value::INT8:
+    return (int32_t) *static_cast<const volatile int8_t *>(_value);
+  case Value::INT16:
+    return (int32_t) *static_cast<const volatile int16_t *>(_value);
+  case Value::TEXT:
+  case Value::COUNTER:
+  case Value::CLOCK:
+    return 0;
+  default:
+    return *static_cast<const volatile int32_t *>(_value);
+  }
+}
+
+int DisplayGroup::getResult() const {
+  return _result;
+}
+
+int DisplayGroup::renderValue(byte * frame, uint32_t value) const {
   if (_nDisplay == 0) {
     return -1;
   }
 
   // Turn off al the displays
   if (!_enabled) {
-    std::vector<Display>::const_iterator beg = _displays.begin();
-    std::vector<Display>::const_iterator end = _displays.end();
-
-    for (; beg != end; ++beg) {
-      (*beg).turnOff();
+    for (byte i = 0; i < _nDisplay; ++i) {
+      frame[i] = 0;
     }
 
     return 0;
   }
 
-  if (!_value) {
+  if (!_value && !_pushed) {
     return -2;
   }
 
-  // Quotient
-  uint16_t quot = *(_value) / 10;
-  uint16_t tempV = quot;
-  // Division counter
-  byte divCount = 1;
-  boolean filled = false;
+  if (_type == Value::TEXT) {
+    return renderText(frame);
+  }
+
+  if (_type == Value::COUNTER) {
+    return renderCounter(frame);
+  }
 
-  // Update the first display
-  _displays[0].update(*(_value) % 10);
+  if (_type == Value::CLOCK) {
+    return renderClock(frame);
+  }
 
-  // Look for zero filling in heading when *(_value) is < 10
-  if (quot == 0) {
-    for (byte i = 1; i < _nDisplay; ++i) {
-      _displays[i].update(0);
-    }
-    filled = true;
+  if (_render) {
+    return _render(*this, frame, value);
   }
 
-  // Count up division by 10 updates display with the remainder
-  while (quot != 0 && divCount < _nDisplay) {
-    quot = tempV / 10;
+  if (_type != Value::UINT16 || _decimals != 0) {
+    return renderWide(frame, value);
+  }
 
-    _displays[divCount].update(tempV % 10);
-    divCount++;
+  // All the decimal digits in one pass, the least significant first
+  byte digits[Bcd::MAX_DIGITS_16];
+  byte count = Bcd::convert((uint16_t) value, digits);
 
-    tempV = quot;
+  // Zero padding in heading when the value uses less digits than the displays
+  for (byte i = 0; i < _nDisplay; ++i) {
+    frame[i] = _digitCodes[i < Bcd::MAX_DIGITS_16 ? digits[i] : 0];
   }
 
   // Return -3 if the number cannot be displayed with the number of displays in
   // the group
-  if (divCount == _nDisplay && quot != 0) {
+  if (count > _nDisplay) {
     return -3;
-  } else if (divCount < _nDisplay && !filled) {
-    // Look for zero filling in heading when *(_value) is > 10
-    for (byte i = divCount; i < _nDisplay; ++i) {
-      _displays[i].update(0);
-    }
   }
 
   return 0;
@@ -105,18 +296,449 @@ byte DisplayGroup::getDisplayNumber() const {
   return _nDisplay;
 }
 
+const byte * DisplayGroup::getDigits() const {
+  return _font.codes;
+}
+
+const Font & DisplayGroup::getFont() const {
+  return _font;
+}
+
+void DisplayGroup::setText(const char * text) {
+  _value = text;
+  _type = Value::TEXT;
+  _decimals = 0;
+  _pushed = false;
+  _rendered = false;
+}
+
+boolean DisplayGroup::setValue(uint32_t value) {
+  // The same sign extension as DisplayGroup::readValue
+  switch (_type) {
+  case Value::UINT16:
+    value = (uint16_t) value;
+    break;
+  case Value::UINT8:
+    value = (uint8_t) value;
+    break;
+  case Value::INT8:
+    value = (int32_t) (int8_t) value;
+    break;
+  case Value::INT16:
+    value = (int32_t) (int16_t) value;
+    break;
+  case Value::TEXT:
+    _type = Value::INT32;
+    break;
+  case Value::COUNTER:
+    value = toCounter(value);
+    break;
+  case Value::CLOCK:
+    return setClock(value);
+  default:
+    break;
+  }
+
+  if (_pushed && _rendered && value == _lastValue) {
+    return false;
+  }
+
+  _value = NULL;
+  _pushed = true;
+  _lastValue = value;
+  _rendered = false;
+
+  return true;
+}
+
+boolean DisplayGroup::count(boolean up, byte * frame) {
+  if (_type != Value::COUNTER) {
+    return false;
+  }
+
+  // A disabled group shows nothing, the digits are rendered when it is enabled again
+  if (!_enabled) {
+    frame = NULL;
+  }
+
+  uint32_t old = _lastValue;
+  uint32_t bcd = old;
+  byte width = getCounterWidth();
+  byte i = 0;
+
+  // Ripple carry: every digit that wraps passes the carry to the next one
+  for (byte shift = 0; i < width; ++i, shift += 4) {
+    byte digit = (byte) (bcd >> shift) & 0x0F;
+
+    if (up) {
+      digit = (digit == 9 ? 0 : digit + 1);
+    } else {
+      digit = (digit == 0 ? 9 : digit - 1);
+    }
+
+    bcd = (bcd & ~((uint32_t) 0x0F << shift)) | (uint32_t) digit << shift;
+
+    if (up ? digit != 0 : digit != 9) {
+      break;
+    }
+  }
+
+  if (i == width && _counterMode == COUNTER_SATURATE) {
+    return false;
+  }
+
+  _lastValue = bcd;
+  _pushed = true;
+
+  if (frame == NULL) {
+    _rendered = false;
+    return true;
+  }
+
+  // The digits changed by the carry, and the one that stopped it
+  byte last = (i < width ? i : width - 1);
+
+  for (byte j = 0; j <= last && j < _nDisplay; ++j) {
+    frame[j] = _digitCodes[(byte) (bcd >> (4 * j)) & 0x0F];
+
+    if (j == _decimals && _decimals != 0) {
+      frame[j] |= _point;
+    }
+  }
+
+  _result = isCounterOverflow() ? -3 : 0;
+
+  return true;
+}
+
+namespace {
+
+// Number of values of each digit of a clock, the tenths first
+const byte CLOCK_RADIX[DisplayGroup::CLOCK_DIGITS] = { 10, 10, 6, 10, 10 };
+
+// Length of a tick of a clock in the unit of the time, for 0 to 3 decimals
+const byte CLOCK_TICK[] = { 1, 1, 10, 100 };
+
+}
+
+boolean DisplayGroup::setClock(uint32_t time) {
+  uint32_t old = _lastValue;
+  byte tick = CLOCK_TICK[_decimals < 3 ? _decimals : 3];
+  boolean jump = (time > _clockTime ? time - _clockTime : _clockTime - time) > (uint32_t) CLOCK_STEPS * tick;
+
+  if (!jump) {
+    // The usual case: the time moved by a few ticks since the last call
+    while (time < _clockTime) {
+      _clockTime -= tick;
+      stepClock(false);
+    }
+
+    while (time - _clockTime >= tick) {
+      if (!stepClock(true)) {
+        // Stopped at the limit
+        jump = true;
+        break;
+      }
+
+      _clockTime += tick;
+    }
+  }
+
+  if (jump) {
+    uint32_t ticks = time / tick;
+    uint32_t seconds = (_decimals == 0 ? ticks : ticks / 10);
+    uint32_t minutes = seconds / 60;
+
+    if (minutes > 99) {
+      _lastValue = 0x99599UL;
+      ticks = (_decimals == 0 ? 99 * 60UL + 59 : (99 * 60UL + 59) * 10 + 9);
+    } else {
+      seconds -= minutes * 60;
+      _lastValue = (uint32_t) (minutes / 10) << 16 | (uint32_t) (minutes % 10) << 12
+          | (uint32_t) (seconds / 10) << 8 | (uint32_t) (seconds % 10) << 4
+          | (_decimals == 0 ? 0 : ticks % 10);
+    }
+
+    _clockTime = ticks * tick;
+  }
+
+  _value = NULL;
+  _pushed = true;
+
+  if (_rendered && _lastValue == old) {
+    return false;
+  }
+
+  _rendered = false;
+  return true;
+}
+
+boolean DisplayGroup::stepClock(boolean up) {
+  uint32_t bcd = _lastValue;
+  byte i = (_decimals == 0 ? 1 : 0);
+
+  // Ripple carry, each digit in its own radix
+  for (byte shift = 4 * i; i < CLOCK_DIGITS; ++i, shift += 4) {
+    byte digit = (byte) (bcd >> shift) & 0x0F;
+    byte last = CLOCK_RADIX[i] - 1;
+
+    if (up) {
+      digit = (digit == last ? 0 : digit + 1);
+    } else {
+      digit = (digit == 0 ? last : digit - 1);
+    }
+
+    bcd = (bcd & ~((uint32_t) 0x0F << shift)) | (uint32_t) digit << shift;
+
+    if (up ? digit != 0 : digit != last) {
+      _lastValue = bcd;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+int DisplayGroup::renderClock(byte * frame) const {
+  // Below one minute the tenths take the place of the minutes
+  boolean minutes = (_decimals == 0 || (_lastValue >> 12) != 0);
+  byte first = (minutes ? 1 : 0);
+  byte size = (minutes ? 4 : 3);
+
+  // Zero padding up to the digits of the format, blank displays after them
+  for (byte i = 0; i < _nDisplay; ++i) {
+    frame[i] = (i < size ? _digitCodes[(byte) (_lastValue >> (4 * (first + i))) & 0x0F] : 0);
+  }
+
+  if (minutes && _nDisplay > 2) {
+    frame[2] |= _point;
+  } else if (!minutes && _nDisplay > 1) {
+    frame[1] |= _point;
+  }
+
+  // The tens of the minutes are not needed below ten minutes
+  byte used = (minutes && (_lastValue >> 16) != 0 ? 4 : 3);
+
+  return used > _nDisplay ? -3 : 0;
+}
+
+uint32_t DisplayGroup::getCount() const {
+  uint32_t value = 0;
+
+  for (byte shift = 4 * COUNTER_DIGITS; shift != 0; shift -= 4) {
+    value = value * 10 + ((byte) (_lastValue >> (shift - 4)) & 0x0F);
+  }
+
+  return value;
+}
+
+void DisplayGroup::setCounterMode(byte mode) {
+  if (mode > COUNTER_SATURATE || mode == _counterMode) {
+    return;
+  }
+
+  _counterMode = mode;
+
+  if (_type == Value::COUNTER) {
+    _lastValue = toCounter(getCount());
+    _rendered = false;
+  }
+}
+
+byte DisplayGroup::getCounterWidth() const {
+  if (_counterMode == COUNTER_OVERFLOW || _nDisplay > COUNTER_DIGITS) {
+    return COUNTER_DIGITS;
+  }
+
+  return _nDisplay;
+}
+
+uint32_t DisplayGroup::toCounter(uint32_t value) const {
+  byte digits[Bcd::MAX_DIGITS_32];
+  byte count = Bcd::convert(value, digits);
+  byte width = getCounterWidth();
+  uint32_t bcd = 0;
+
+  for (byte i = width; i > 0; --i) {
+    bcd = bcd << 4 | (count > width && _counterMode == COUNTER_SATURATE ? 9 : digits[i - 1]);
+  }
+
+  return bcd;
+}
+
+boolean DisplayGroup::isCounterOverflow() const {
+  return _nDisplay < COUNTER_DIGITS && (_lastValue >> (4 * _nDisplay)) != 0;
+}
+
+int DisplayGroup::renderCounter(byte * frame) const {
+  for (byte i = 0; i < _nDisplay; ++i) {
+    frame[i] = _digitCodes[i < COUNTER_DIGITS ? (byte) (_lastValue >> (4 * i)) & 0x0F : 0];
+  }
+
+  if (_decimals != 0 && _decimals < _nDisplay) {
+    frame[_decimals] |= _point;
+  }
+
+  return isCounterOverflow() ? -3 : 0;
+}
+
+uint16_t DisplayGroup::getOffset() const {
+  return _offset;
+}
+
+void DisplayGroup::setOffset(uint16_t offset) {
+  _offset = offset;
+}
+
 byte DisplayGroup::getBitOrder() const {
   return _bitOrder;
 }
 
 void DisplayGroup::setBitOrder(byte byteOrder) {
-  _bitOrder = byteOrder;
+  if (byteOrder != _bitOrder) {
+    _bitOrder = byteOrder;
+
+    // The codes, minus and point included, are reversed once here
+    buildDigitCodes();
+    _minus = DisplayManager::reverseBits(_minus);
+    _point = DisplayManager::reverseBits(_point);
+  }
+}
+
+int DisplayGroup::renderWide(byte * frame, uint32_t value) const {
+  // Sign and magnitude, in the width of the watched variable
+  boolean negative = false;
+
+  if ((_type == Value::INT8 || _type == Value::INT16 || _type == Value::INT32) && (int32_t) value < 0) {
+    negative = true;
+    value = 0 - value;
+  }
+
+  byte digits[Bcd::MAX_DIGITS_32];
+  byte size, count;
+
+  if (_type == Value::UINT8 || _type == Value::INT8) {
+    size = Bcd::MAX_DIGITS_8;
+    count = Bcd::convert((uint8_t) value, digits);
+  } else if (_type == Value::UINT16 || _type == Value::INT16) {
+    size = Bcd::MAX_DIGITS_16;
+    count = Bcd::convert((uint16_t) value, digits);
+  } else {
+    size = Bcd::MAX_DIGITS_32;
+    count = Bcd::convert(value, digits);
+  }
+
+  // Zero padding in heading, the units are always shown with a fixed point value
+  for (byte i = 0; i < _nDisplay; ++i) {
+    frame[i] = _digitCodes[i < size ? digits[i] : 0];
+  }
+
+  if (_decimals != 0 && _decimals < _nDisplay) {
+    frame[_decimals] |= _point;
+  }
+
+  if (count <= _decimals) {
+    count = _decimals + 1;
+  }
+
+  if (negative) {
+    // The minus takes the most significant display
+    frame[_nDisplay - 1] = _minus;
+    ++count;
+  }
+
+  return count > _nDisplay ? -3 : 0;
+}
+
+int DisplayGroup::renderText(byte * frame) const {
+  const char * text = static_cast<const char *>(_value);
+  byte i = _nDisplay;
+
+  // The first character on the most significant display
+  for (; *text != '\0'; ++text) {
+    if (*text == '.' && i < _nDisplay) {
+      frame[i] |= _point;
+      continue;
+    }
+
+    if (i == 0) {
+      break;
+    }
+
+    byte code = _font.getCode(*text);
+    frame[--i] = (_bitOrder == MSBFIRST ? code : DisplayManager::reverseBits(code));
+  }
 
-  std::vector<Display>::iterator beg = _displays.begin();
-  std::vector<Display>::iterator end = _displays.end();
-  for (; beg != end; ++beg) {
-    (*beg).setBitOrder(_bitOrder);
+  // Blank padding in trailing
+  while (i != 0) {
+    frame[--i] = 0;
   }
+
+  return *text != '\0' ? -3 : 0;
+}
+
+void DisplayGroup::buildDigitCodes() {
+  for (byte i = 0; i < DIGITS_SIZE; ++i) {
+    byte code = _font.getCode('0' + i);
+    _digitCodes[i] = (_bitOrder == MSBFIRST ? code : DisplayManager::reverseBits(code));
+  }
+}
+
+void DisplayGroup::setSequence(const Sequence * sequence) {
+  _sequence = sequence;
+}
+
+void DisplayGroup::setSymbols(byte minus, byte point) {
+  _minus = (_bitOrder == MSBFIRST ? minus : DisplayManager::reverseBits(minus));
+  _point = (_bitOrder == MSBFIRST ? point : DisplayManager::reverseBits(point));
+}
+
+byte DisplayGroup::getChain() const {
+  return _chain;
+}
+
+void DisplayGroup::setChain(byte chain) {
+  _chain = chain;
+}
+
+boolean DisplayGroup::isAnimated() const {
+  return _animation != NULL;
+}
+
+void DisplayGroup::setAnimation(const Animation * animation, uint16_t frame) {
+  if ((animation == NULL) != (_animation == NULL)) {
+    _rendered = false;
+  }
+
+  _animation = animation;
+  _animationFrame = frame;
+}
+
+boolean DisplayGroup::renderAnimation(byte * frame) const {
+  boolean changed = false;
+
+  if (!_animation) {
+    return changed;
+  }
+
+  byte * out = frame + _nDisplay;
+
+  // The leftmost display is the last one of the group in the frame, a disabled group is
+  // blank
+  for (byte i = 0; i < _nDisplay; ++i) {
+    byte code = _enabled ? _animation->getCode(_animationFrame, i, _nDisplay) : 0;
+
+    if (_bitOrder != MSBFIRST) {
+      code = DisplayManager::reverseBits(code);
+    }
+
+    if (*--out != code) {
+      *out = code;
+      changed = true;
+    }
+  }
+
+  return changed;
 }
 
 void DisplayGroup::setEnabled(boolean enabled) {
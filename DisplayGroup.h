@@ -20,32 +20,151 @@
 
 #include <Arduino.h>
 
-#include <Display.h>
+#include <Bcd.h>
+#include <Font.h>
 
-#include <iterator>
-#include <vector>
+// Type of the count of a Sequence, a byte read and written atomically. A core that
+// models it as an object, as the host simulation does, defines it before the library headers.
+#ifndef DISPLAYGROUP_SEQUENCE_COUNT
+#define DISPLAYGROUP_SEQUENCE_COUNT volatile byte
+#endif
 
 namespace DisplayGroup {
 
-class Display;
+typedef DISPLAYGROUP_SEQUENCE_COUNT SequenceCount;   /**< Count of a Sequence */
+
+class Animation;
+class DisplayGroup;
+
+/**
+ * Pointer to the function that converts the value of a group in 7-segments codes,
+ * see DisplayGroup::render.
+ */
+typedef int (*RenderFunction)(const DisplayGroup & group, byte * frame, uint16_t value);
+
+/**
+ * @brief Sequence counter of variables written by an interrupt.
+ *
+ * On an 8 bits microcontroller a variable of 16 or 32 bits is read one byte at a time: an
+ * interrupt that writes it during the read leaves the group with a torn value, e.g. the
+ * high byte of the new value and the low byte of the old one. The interrupt bumps the
+ * counter each time it writes one of the variables, and the group reads the value again
+ * until the counter did not move during the read, see DisplayManager::setSequence. The
+ * counter is one byte, read and written atomically, so the interrupts are never disabled.
+ * The writer must be an interrupt, or run with the interrupts disabled: the group never
+ * interrupts the writer, so the counter needs no odd "write in progress" state.
+ */
+class Sequence {
+public:
+
+  /**
+   * Constructor.
+   */
+  Sequence();
+
+  /**
+   * Mark a write of the variables, in the interrupt that writes them.
+   */
+  void bump();
+
+  /**
+   * @return The number of writes, wrapping around
+   */
+  byte read() const;
+
+private:
+  SequenceCount _count;           /**< Number of writes */
+};
 
 /**
- * @brief Group of 7-segments displays. Holds a vector of Display objects, updates every display
- * with the correct digit.
+ * @brief Address and format of the value watched by a DisplayGroup.
+ *
+ * Built implicitly from the address of an 8, 16 or 32 bits, signed or unsigned, variable.
+ * Negative values are shown with the minus code on the most significant display.
+ * A fixed point value is an integer with a number of decimals: the decimal point is lit on
+ * the display of the units, e.g. 125 with 1 decimal is shown as 12.5.
+ * A text is a null terminated string, shown from the most significant display with the
+ * font of the group, see Font: it is rendered again only when set with
+ * DisplayManager::setText, not when its characters change in place.
+ * A pushed value has no variable: it is stored in the group by DisplayManager::setValue,
+ * and it is converted in the format given by its type. A counter is a pushed value kept
+ * in decimal digits, changed by DisplayManager::increment and DisplayManager::decrement.
+ * A clock is a pushed duration, shown as mm:ss, or as ss.t below one minute when it has
+ * decimals: it is fed with DisplayManager::setValue from a counter of seconds (0 decimals),
+ * tenths (1), hundredths (2) or milliseconds (3) of second.
+ * A variable written by an interrupt is read consistently through a Sequence, see
+ * DisplayManager::setSequence.
+ */
+class Value {
+public:
+
+  /**
+   * Type of the watched variable.
+   */
+  enum Type {
+    UINT16 = 0,     /**< uint16_t, the conversion path of the library since its first version */
+    UINT8,          /**< uint8_t */
+    UINT32,         /**< uint32_t */
+    INT8,           /**< int8_t */
+    INT16,          /**< int16_t */
+    INT32,          /**< int32_t */
+    TEXT,           /**< Null terminated string */
+    COUNTER,        /**< Pushed counter, kept in decimal digits, see DisplayGroup::count */
+    CLOCK           /**< Pushed duration, kept in minutes, seconds and tenths digits */
+  };
+
+  /**
+   * Constructors, one for each type of variable.
+   *
+   * @param[in] value       Address of the variable to watch
+   * @param[in] decimals    Number of decimals of a fixed point value, 0 for an integer
+   */
+  Value(const uint16_t * value, byte decimals = 0);
+  Value(const uint8_t * value, byte decimals = 0);
+  Value(const uint32_t * value, byte decimals = 0);
+  Value(const int8_t * value, byte decimals = 0);
+  Value(const int16_t * value, byte decimals = 0);
+  Value(const int32_t * value, byte decimals = 0);
+
+  /**
+   * Constructor of a text.
+   *
+   * @param[in] text        The string to show, it must outlive the group
+   */
+  Value(const char * text);
+
+  /**
+   * Constructor of a pushed value, 0 until the first DisplayManager::setValue.
+   *
+   * @param[in] type        Value::Type of the value, except Value::TEXT
+   * @param[in] decimals    Number of decimals of a fixed point value, 0 for an integer
+   */
+  Value(Type type, byte decimals = 0);
+
+  const void * address;   /**< Address of the variable, NULL for a pushed value */
+  byte type;              /**< Value::Type of the variable */
+  byte decimals;          /**< Number of decimals */
+  boolean pushed;         /**< True for a pushed value */
+};
+
+/**
+ * @brief Group of 7-segments displays. Renders the correct digit for every display.
  *
  * This class represents a group of n 7-segments displays, which can show an n digits number.
- * Each group has a vector of displays, and a value to show, using all the displays.
+ * Each group has a value to show, using all the displays, and the state shared by all of them:
+ * the array of 7-segments codes, the bit order and the enable flag. The per display state is
+ * the code itself, stored in the frame buffer of the DisplayManager.
  * The class take the address of the variable to monitor, and does all the computation to send
  * the i-th digit to the i-th display, with automatic zero padding on the heading and trailing
  * if the value to show uses less digits than the number of displays in the group.
  * If the value to show uses more digits than the number of displays in the group only the least
  * significant digits are showed.
- *
- * This class uses the STL library for Arduino, which can be found at
- * @htmlonly
- * <a href="http://andybrown.me.uk/wk/2011/01/15/the-standard-template-library-stl-for-avr-with-c-streams/">
- * the-standard-template-library-stl-for-avr-with-c-streams </a>
- * @endhtmlonly
+ * The watched variable can be 8, 16 or 32 bits wide, signed or unsigned, and can have a fixed
+ * number of decimals, see Value. An unsigned 16 bits integer is converted on the same path
+ * it always had; the other formats are converted by the function of their width.
+ * The 7-segments codes of the digits, the minus and the decimal point are read from the
+ * font once, when the group is built, in the order they are shifted out: the conversion
+ * reads each code from RAM with a single indexed load even when the font is in flash.
  *
  * @author Gionata Boccalini
  * @date   Feb 10, 2013
@@ -53,35 +172,105 @@ class Display;
 class DisplayGroup {
 public:
 
+  static const byte DIGITS_SIZE = 10;   /**< Number of 7-segments codes in a digits array [0-9] */
+  static const byte COUNTER_DIGITS = 8;             /**< Number of decimal digits of a counter */
+  static const byte CLOCK_DIGITS = 5;               /**< Digits of a clock: tenths, seconds and minutes */
+  static const byte CLOCK_STEPS = 100;              /**< Longest change of a clock made by steps, in ticks */
+
+  /**
+   * What a counter does when it counts past its digits, see DisplayGroup::count.
+   */
+  enum CounterMode {
+    COUNTER_OVERFLOW = 0,   /**< Count on DisplayGroup::COUNTER_DIGITS digits, as a watched value: the
+                                 render returns -3 when the count does not fit in the displays */
+    COUNTER_WRAP,           /**< Count on the digits of the displays: past the last digit to 0, below 0
+                                 to all nines */
+    COUNTER_SATURATE        /**< Count on the digits of the displays: stop at all nines and at 0 */
+  };
+
   /**
    * Constructor.
    *
    * @param[in] nDisplay	Number of display in the group
    * @param[in] id	    	Id of the DisplayGroup in the manager
-   * @param[in] *value  	Address of the value to be monitored
-   * @param[in] digits[]    Array of 7-segments code for each digits [0-9]
+   * @param[in] value   	Address and format of the value to be monitored
+   * @param[in] font        7-segments codes of the digits, and of the characters of a text,
+   *                        e.g. an array of code for each digits [0-9]
    */
-  DisplayGroup(byte nDisplay, byte id, uint16_t * value, const byte digits[]);
+  DisplayGroup(byte nDisplay, byte id, const Value & value, const Font & font);
 
+  /**
+   * Constructor for a group with a number of displays fixed at compile time. The value
+   * is rendered by render, usually DisplayGroup::renderFixed<nDisplay>.
+   *
+   * @param[in] nDisplay    Number of display in the group
+   * @param[in] id          Id of the DisplayGroup in the manager
+   * @param[in] *value      Address of the value to be monitored
+   * @param[in] font        7-segments codes of the digits, e.g. an array of code for each
+   *                        digits [0-9]
+   * @param[in] render      Function that converts the value of the group
+   */
+  DisplayGroup(byte nDisplay, byte id, uint16_t * value, const Font & font, RenderFunction render);
 
   /** Default destructor.
    */
-  virtual ~DisplayGroup();
+  ~DisplayGroup();
+
+  /**
+   * Convert the value of a group of N displays in 7-segments codes. The number of
+   * displays is a compile time constant, so the loop on the digits is fully unrolled.
+   *
+   * @param[in]  group      The group, with N displays
+   * @param[out] frame      Buffer of at least N bytes
+   * @param[in]  value      Snapshot of the watched value
+   * @return As DisplayGroup::render
+   */
+  template <byte N>
+  static int renderFixed(const DisplayGroup & group, byte * frame, uint16_t value);
 
   /**
    * Scans the value to be showed and count how many digits must be sent to the displays.
-   * The count is made by dividing and considering the remainder of divisions by 10, until
-   * the quotient is zero or there are no display available in the group any more.
-   * The method does automatic padding (filling) with zeros when needed in the heading and
-   * trailing of the displays vector.
+   * All the decimal digits and their count are extracted in one pass by Bcd::convert,
+   * without divisions.
+   * The method does automatic padding (filling) with zeros when needed in the heading
+   * displays.
+   * The 7-segments code of the i-th display is written in frame[i], in the order the
+   * bytes are shifted out to the chain; nothing is sent to the hardware.
+   *
+   * The value, the enable flag and the bit order used are remembered, see
+   * DisplayGroup::isChanged.
+   *
+   * @param[out] frame      Buffer of at least DisplayGroup::getDisplayNumber bytes
    *
    * @return -1		If _nDisplay is equal to zero
    * @return -2		If _value is NULL
-   * @return -3		If the whole value cannot be displayed with the number of displays in
-   *				the group
+   * @return -3		If the whole value, with its minus, or the whole text cannot be displayed
+   *				with the number of displays in the group
    * @return  0		On success
    */
-  int update() const;
+  int render(byte * frame);
+
+  /**
+   * @return True if the group has never been rendered, or if the watched value, the enable
+   *         flag or the bit order changed since the last DisplayGroup::render; while the
+   *         group is animated, only if the enable flag changed
+   */
+  boolean isChanged() const;
+
+  /**
+   * Render the group only if it changed, see DisplayGroup::isChanged: the watched value is
+   * read once, and the same snapshot is compared with the last one and rendered. A value
+   * written by an interrupt between the check and the render cannot be missed.
+   *
+   * @param[out] frame      Buffer of at least DisplayGroup::getDisplayNumber bytes
+   * @return True if the group has been rendered
+   */
+  boolean renderChanged(byte * frame);
+
+  /**
+   * @return The return value of the last DisplayGroup::render
+   */
+  int getResult() const;
 
   /**
    *
@@ -95,6 +284,72 @@ public:
    */
   byte getDisplayNumber() const;
 
+  /**
+   *
+   * @return The array of 7-segments code of the font, in RAM or in flash, see
+   *         DisplayGroup::getFont
+   */
+  const byte * getDigits() const;
+
+  /**
+   *
+   * @return The font of the group
+   */
+  const Font & getFont() const;
+
+  /**
+   * Show a text instead of the watched value, rendered at the next update.
+   *
+   * @param[in] text        The string to show, see Value
+   */
+  void setText(const char * text);
+
+  /**
+   * Store a pushed value in the group, instead of the watched variable, see Value. The
+   * group is changed until the next render, unless the value is the one shown.
+   *
+   * @param[in] value       The value, converted in the format of the group: a text group
+   *                        becomes a Value::INT32 group, see DisplayGroup::setClock for a
+   *                        Value::CLOCK group
+   * @return True if the group must be rendered again
+   */
+  boolean setValue(uint32_t value);
+
+  /**
+   * Count one up or down, with the ripple carry on the decimal digits of a Value::COUNTER
+   * group: on average one digit changes, and no conversion from binary is needed. Only the
+   * changed digits are written in the frame, the group is changed until the next render
+   * when there is no frame.
+   *
+   * @param[in]  up         True to count up, false to count down
+   * @param[out] frame      The displays of the group in the frame buffer, as laid out by the
+   *                        last render, or NULL
+   * @return True if the count changed
+   */
+  boolean count(boolean up, byte * frame);
+
+  /**
+   * @return The count of a Value::COUNTER group, in binary
+   */
+  uint32_t getCount() const;
+
+  /**
+   * @param[in] mode        The DisplayGroup::CounterMode of a Value::COUNTER group, the
+   *                        count is kept
+   */
+  void setCounterMode(byte mode);
+
+  /**
+   * @return The position of the first display of the group in the frame buffer, as laid
+   *         out by the last DisplayManager::updateAll
+   */
+  uint16_t getOffset() const;
+
+  /**
+   * @param[in] offset      The position of the first display of the group in the frame buffer
+   */
+  void setOffset(uint16_t offset);
+
   /**
    *
    * @return The bit order in every display
@@ -102,12 +357,67 @@ public:
   byte getBitOrder() const;
 
   /**
+   *
+   * The codes of the group are bit reversed once here, so the shift out to the chain
+   * always runs in the same direction over the pre-transformed bytes.
    *
    * @param[in] bitOrder	The bit order in every display. Can LSBFIRST or MSBFIRST,
    * 						as in Arduino specification
    */
   void setBitOrder(byte bitOrder);
 
+  /**
+   *
+   * @return The chain of the group, see DisplayManager::setChain
+   */
+  byte getChain() const;
+
+  /**
+   * @param[in] chain       The chain of the group, see DisplayManager::setChain
+   */
+  void setChain(byte chain);
+
+  /**
+   * @param[in] sequence    The sequence counter bumped by the interrupt that writes the
+   *                        watched value, NULL if the value is written by the loop
+   */
+  void setSequence(const Sequence * sequence);
+
+  /**
+   * Set the codes of the minus and of the decimal point, for digits arrays that do not use
+   * the segments of DisplayManager::DEF_DIGITS.
+   *
+   * @param[in] minus       7-segments code of the minus
+   * @param[in] point       7-segments code of the decimal point, or-ed with the digit code
+   */
+  void setSymbols(byte minus, byte point);
+
+  /**
+   * @return True while the group shows the codes of an animation instead of its value
+   */
+  boolean isAnimated() const;
+
+  /**
+   * Show a frame of an animation instead of the value: an animated group is never changed,
+   * its displays belong to the animation, and DisplayGroup::render writes the codes of the
+   * frame. Back to its value, the group is rendered again at the next update.
+   *
+   * @param[in] animation   The codes, they must outlive the frame shown, NULL to show the
+   *                        value again, see DisplayManager::showCodes
+   * @param[in] frame       The frame to show, see Animation::getFrameCount
+   */
+  void setAnimation(const Animation * animation, uint16_t frame);
+
+  /**
+   * Write the codes of the animation frame given to DisplayGroup::setAnimation, in the
+   * bit order of the group, leftmost display last, or blanks when the group is disabled.
+   * Only the differing codes are written.
+   *
+   * @param[out] frame      Buffer of at least DisplayGroup::getDisplayNumber bytes
+   * @return True if a code differs from the buffer
+   */
+  boolean renderAnimation(byte * frame) const;
+
   /**
    * Set the enable flag
    * @param enabled         True to enable the group or false to disable it. All the
@@ -117,14 +427,172 @@ public:
 
 private:
 
-  std::vector<Display> _displays; /**< Vector of 7-segments displays */
+  /**
+   * Convert the value in 7-segments codes, see DisplayGroup::render.
+   *
+   * @param[out] frame      Buffer of at least DisplayGroup::getDisplayNumber bytes
+   * @param[in]  value      Snapshot of the watched value
+   */
+  int renderValue(byte * frame, uint32_t value) const;
+
+  /**
+   * Render a snapshot of the watched value and remember it, see DisplayGroup::render.
+   *
+   * @param[out] frame      Buffer of at least DisplayGroup::getDisplayNumber bytes
+   * @param[in]  value      Snapshot of the watched value, ignored when the group is disabled
+   */
+  int renderSnapshot(byte * frame, uint32_t value);
+
+  /**
+   * Convert a value that is not an unsigned 16 bits integer, see DisplayGroup::render.
+   *
+   * @param[out] frame      Buffer of at least DisplayGroup::getDisplayNumber bytes
+   * @param[in]  value      Snapshot of the watched value, sign extended
+   */
+  int renderWide(byte * frame, uint32_t value) const;
+
+  /**
+   * Convert the watched text, see DisplayGroup::render. A '.' lights the decimal point of
+   * the previous character, without taking a display.
+   *
+   * @param[out] frame      Buffer of at least DisplayGroup::getDisplayNumber bytes
+   */
+  int renderText(byte * frame) const;
+
+  /**
+   * Feed a Value::CLOCK group with the elapsed time. The digits follow the time one tick
+   * at a time, a tenth of second or a second without decimals, with the carry rippling
+   * through the tenths, seconds and minutes, so a clock fed at every loop never divides.
+   * A change longer than DisplayGroup::CLOCK_STEPS ticks is converted once. The clock
+   * stops at 99:59.9.
+   *
+   * @param[in] time        The time, in the unit given by the decimals of the group
+   * @return True if the digits changed
+   */
+  boolean setClock(uint32_t time);
+
+  /**
+   * One tick up or down on the digits of a clock.
+   *
+   * @param[in] up          True to count up
+   * @return False if the clock is at its limit, the digits are not changed
+   */
+  boolean stepClock(boolean up);
+
+  /**
+   * Convert the digits of a clock, see DisplayGroup::render. Below one minute the point of
+   * the seconds is lit, otherwise the point of the minutes, wired as the colon on clock
+   * displays.
+   *
+   * @param[out] frame      Buffer of at least DisplayGroup::getDisplayNumber bytes
+   */
+  int renderClock(byte * frame) const;
+
+  /**
+   * Convert the decimal digits of a counter, see DisplayGroup::render.
+   *
+   * @param[out] frame      Buffer of at least DisplayGroup::getDisplayNumber bytes
+   */
+  int renderCounter(byte * frame) const;
+
+  /**
+   * @return The number of decimal digits the counter counts on, see DisplayGroup::CounterMode
+   */
+  byte getCounterWidth() const;
+
+  /**
+   * @param[in] value       A binary value
+   * @return The value in packed decimal digits, 4 bits each, limited as the counter mode
+   *         requires
+   */
+  uint32_t toCounter(uint32_t value) const;
+
+  /**
+   * @return True if the counter does not fit in the displays
+   */
+  boolean isCounterOverflow() const;
+
+  /**
+   * @return The watched value, sign extended to 32 bits, read until the sequence counter
+   *         of the group did not move during the read
+   */
+  uint32_t readValue() const;
+
+  /**
+   * @return The watched value, sign extended to 32 bits, read once
+   */
+  uint32_t readVariable() const;
+
+  /**
+   * Unrolled copy of the 7-segments codes of the digits I to N - 1 in the frame.
+   */
+  template <byte I, byte N>
+  struct DigitWriter {
+    static inline void write(byte * frame, const byte digits[], const byte codes[]) {
+      frame[I] = codes[digits[I]];
+      DigitWriter<I + 1, N>::write(frame, digits, codes);
+    }
+  };
+
+  /**
+   * End of the DigitWriter recursion.
+   */
+  template <byte N>
+  struct DigitWriter<N, N> {
+    static inline void write(byte *, const byte [], const byte []) {
+    }
+  };
+
+  /**
+   * Read the codes of the digits from the font in DisplayGroup::_digitCodes, in the bit
+   * order of the group.
+   */
+  void buildDigitCodes();
+
+  Font _font;                     /**< 7-segments codes of the digits and of the text */
+  byte _digitCodes[DIGITS_SIZE];  /**< Codes of the digits [0-9], in the order they are shifted out */
+  byte _minus;                    /**< Code of the minus, in the bit order of the group */
+  byte _point;                    /**< Code of the decimal point, in the bit order of the group */
+  RenderFunction _render;         /**< Function that converts the value, NULL for any number of displays */
   byte _id;                       /**< Id of the DisplayGroup */
-  uint16_t * _value;              /**< Address of the value to be monitored */
+  const void * _value;            /**< Address of the value to be monitored */
+  const Sequence * _sequence;     /**< Sequence counter of the value, NULL if not written by an interrupt */
+  byte _type;                     /**< Value::Type of the value */
+  byte _decimals;                 /**< Number of decimals of the value */
   byte _nDisplay;                 /**< Number of display in the group */
-  byte _bitOrder;                 /**< Bit order in every display */
+  byte _bitOrder;                 /**< Bit order of all the displays */
+  byte _chain;                    /**< Chain of the displays */
   boolean _enabled;               /**< Enable flag */
+  const Animation * _animation;   /**< Animation that owns the displays, NULL to show the value */
+  uint16_t _animationFrame;       /**< Frame of the animation shown */
+  boolean _pushed;                /**< True when the value is stored in DisplayGroup::_lastValue */
+  uint16_t _offset;               /**< Position of the group in the frame buffer */
+  byte _counterMode;              /**< DisplayGroup::CounterMode of a counter */
+  uint32_t _clockTime;            /**< Time of the digits of a clock, at the last tick */
+
+  uint32_t _lastValue;            /**< Value used by the last render, sign extended, packed decimal
+                                       digits for a counter and a clock */
+  byte _lastBitOrder;             /**< Bit order used by the last render */
+  boolean _lastEnabled;           /**< Enable flag used by the last render */
+  boolean _rendered;              /**< True after the first render */
+  int8_t _result;                 /**< Return value of the last render */
 };
 
+template <byte N>
+int DisplayGroup::renderFixed(const DisplayGroup & group, byte * frame, uint16_t value) {
+  // Room for the heading zeros when the group is wider than a 16 bits value
+  byte digits[N > Bcd::MAX_DIGITS_16 ? N : Bcd::MAX_DIGITS_16];
+  byte count = Bcd::convert(value, digits);
+
+  for (byte i = Bcd::MAX_DIGITS_16; i < N; ++i) {
+    digits[i] = 0;
+  }
+
+  DigitWriter<0, N>::write(frame, digits, group._digitCodes);
+
+  return count > N ? -3 : 0;
+}
+
 } /* namespace DisplayGroup */
 
 #endif /* DISPLAYGROUP_H_ */
@@ -30,147 +30,1033 @@ const byte DisplayManager::DEF_DIGITS[10] = { 1 + 4 + 8 + 16 + 32 + 64,
                                               1 + 2 + 4 + 8 + 16 + 32 + 64,
                                               2 + 4 + 8 + 16 + 32 + 64 };
 
-const byte DisplayManager::DEF_ORDER = LSBFIRST;
+const byte DisplayManager::DEF_ORDER = MSBFIRST;
+const byte DisplayManager::DEF_MINUS = 2;
+const byte DisplayManager::DEF_POINT = 128;
 const byte DisplayManager::DEF_OUTPUT_ENABLE_W_STATE = HIGH;
+const byte DisplayManager::NO_GROUP;
 
-byte DisplayManager::dataPin = PIN_COM_DATA;
-byte DisplayManager::clockPin = PIN_COM_CLOCK;
-byte DisplayManager::outputEnablePin = PIN_OUTPUT_ENABLE;
-byte DisplayManager::outputEnablePinState = DEF_OUTPUT_ENABLE_W_STATE;
+DisplayManager::DisplayManager(byte dataP, byte clockP, byte outputEnableP, byte outputEnableState) :
+      _outputEnablePin(outputEnableP), _outputEnableState(outputEnableState) {
 
-/**
- * @brief Binary predicate for STL find_if, replace_if algorithms
- */
-struct GroupId: public std::binary_function<DisplayGroup, byte, bool> {
-  /**
-   * Unary operator to compare DisplayGroups
-   * @param[in] gr      DisplayGroup in input
-   * @param[in] id      Id to match
-   * @return
-   */
-  bool operator () (const DisplayGroup &gr, const byte &id) const {
-    return gr.getId() == id;
+  _transport = new (&_bitBang) BitBangTransport(dataP, clockP);
+  init();
+  setup();
+}
+
+DisplayManager::DisplayManager(ShiftTransport & transport, byte outputEnableP, byte outputEnableState) :
+      _outputEnablePin(outputEnableP), _outputEnableState(outputEnableState) {
+
+  // The software transport is not built
+  _transport = &transport;
+  init();
+  setup();
+}
+
+DisplayManager::~DisplayManager() {
+  clearGroups();
+
+  if (!_fixed) {
+    delete[] _slots;
+    delete[] _order;
+    delete[] _index;
+    delete[] _frame;
+    delete[] _front;
+  }
+
+  // The software transport is destroyed only if it was built
+  BitBangTransport * bitBang = reinterpret_cast<BitBangTransport *>(&_bitBang);
+
+  if (_transport == bitBang) {
+    bitBang->~BitBangTransport();
   }
-};
+}
 
-DisplayManager::DisplayManager(byte dataP, byte clockP, byte outputEnableP, byte outputEnableState) {
-  // Setup static variables
-  dataPin = dataP;
-  clockPin = clockP;
-  outputEnablePin = outputEnableP;
-  outputEnablePinState = outputEnableState;
+void DisplayManager::init() {
+  _slots = NULL;
+  _order = NULL;
+  _index = NULL;
+  _frame = NULL;
+  _front = NULL;
+  _groupCapacity = 0;
+  _idCapacity = 0;
+  _displayCapacity = 0;
+  _frontCapacity = 0;
+  _fixed = false;
 
-  pinMode(dataPin, OUTPUT);
-  pinMode(clockPin, OUTPUT);
-  pinMode(outputEnablePin, OUTPUT);
+  _count = 0;
+  _displays = 0;
+  _frameSize = 0;
+  _chains = 1;
+  _chainSize[0] = 0;
+  _dirtyChains = 0;
+  _segments = 1;
+  _segmentPin[0] = _outputEnablePin;
+  _peakGroups = 0;
+  _peakIds = 0;
+  _peakDisplays = 0;
 
-  digitalWrite(outputEnablePin, !outputEnablePinState);
+  _changed = true;
+  _batchDepth = 0;
+  _lastResult = 0;
+  _pending = false;
+  _busy = false;
+  _latchCount = 0;
+  _shiftMask = 0;
+  _shiftSegment = 0;
+  _dimmingPin = NO_PIN;
+  _brightness = 255;
 }
 
-DisplayManager::~DisplayManager() {
+void DisplayManager::setup() {
+  pinMode(_outputEnablePin, OUTPUT);
+  digitalWrite(_outputEnablePin, !_outputEnableState);
+
+  _transport->begin();
+}
+
+void DisplayManager::usePool(const GroupPool & pool) {
+  assert(_count == 0 && _slots == NULL);
+
+  _slots = pool.slots;
+  _order = pool.order;
+  _index = pool.index;
+  _frame = pool.frame;
+  _front = pool.front;
+  _groupCapacity = pool.groups;
+  _idCapacity = pool.ids;
+  _displayCapacity = pool.displays;
+  _frontCapacity = pool.front == NULL ? 0 : pool.displays;
+  _fixed = true;
+
+  for (uint16_t id = 0; id < _idCapacity; ++id) {
+    _index[id] = NO_GROUP;
+  }
+}
+
+boolean DisplayManager::addGroup(byte id, byte nDisplay, const Value & value) {
+  return addGroup(id, nDisplay, value, DEF_DIGITS, sizeof(DEF_DIGITS));
+}
+
+boolean DisplayManager::addGroup(byte id, byte nDisplay, const Value & value, const byte digits[], byte sizeOfDigits) {
+  return insertGroup(id, nDisplay, _count, value, digits, sizeOfDigits);
+}
 
+boolean DisplayManager::addGroup(byte id, byte nDisplay, const Value & value, const Font & font) {
+  return insertGroup(id, nDisplay, _count, value, font);
 }
 
-void DisplayManager::addGroup(byte id, byte nDisplay, uint16_t * value) {
-  addGroup(id, nDisplay, value, DEF_DIGITS, sizeof(DEF_DIGITS));
+boolean DisplayManager::insertGroup(byte id, byte nDisplay, byte index, const Value & value) {
+  return insertGroup(id, nDisplay, index, value, DEF_DIGITS, sizeof(DEF_DIGITS));
 }
 
-void DisplayManager::addGroup(byte id, byte nDisplay, uint16_t * value, const byte digits[], byte sizeOfDigits) {
-  assert(digits != NULL && sizeOfDigits == 10);
+boolean DisplayManager::insertGroup(byte id, byte nDisplay, byte index, const Value & value, const byte digits[], byte sizeOfDigits) {
+  assert(sizeOfDigits >= DisplayGroup::DIGITS_SIZE && digits != NULL);
 
-  if (std::find_if(_groups.begin(), _groups.end(), std::bind2nd(GroupId(), id)) == _groups.end()) {
-    // A group with this id has not been found
-    DisplayGroup disGroup(nDisplay, id, value, digits);
-    _groups.push_back(disGroup);
+  return insertGroup(id, nDisplay, index, value, Font(digits, sizeOfDigits, '0', false));
+}
+
+boolean DisplayManager::insertGroup(byte id, byte nDisplay, byte index, const Value & value, const Font & font) {
+  assert(font.codes != NULL);
+
+  void * slot = newGroup(id, nDisplay, index);
+
+  if (slot == NULL) {
+    return false;
   }
+
+  new (slot) DisplayGroup(nDisplay, id, value, font);
+  return true;
+}
+
+boolean DisplayManager::replaceGroup(byte id, byte nDisplay, const Value & value) {
+  return replaceGroup(id, nDisplay, value, DEF_DIGITS, sizeof(DEF_DIGITS));
 }
 
-void DisplayManager::insertGroup(byte id, byte nDisplay, byte index, uint16_t * value) {
-  insertGroup(id, nDisplay, index, value, DEF_DIGITS, sizeof(DEF_DIGITS));
+boolean DisplayManager::replaceGroup(byte id, byte nDisplay, const Value & value, const byte digits[], byte sizeOfDigits) {
+  assert(sizeOfDigits >= DisplayGroup::DIGITS_SIZE && digits != NULL);
+
+  return replaceGroup(id, nDisplay, value, Font(digits, sizeOfDigits, '0', false));
 }
 
-void DisplayManager::insertGroup(byte id, byte nDisplay, byte index, uint16_t * value, const byte digits[], byte sizeOfDigits) {
-  assert(index >= 0 && index <= _groups.size() && digits != NULL && sizeOfDigits == 10);
+boolean DisplayManager::replaceGroup(byte id, byte nDisplay, const Value & value, const Font & font) {
+  assert(font.codes != NULL);
+
+  void * slot = renewGroup(id, nDisplay);
 
-  if (std::find_if(_groups.begin(), _groups.end(), std::bind2nd(GroupId(), id)) == _groups.end()) {
-    // A group with this id has not been found
-    DisplayGroup disGroup(nDisplay, id, value, digits);
-    _groups.insert(_groups.begin() + index, disGroup);
+  if (slot == NULL) {
+    return false;
   }
+
+  new (slot) DisplayGroup(nDisplay, id, value, font);
+  return true;
 }
 
-void DisplayManager::replaceGroup(byte id, byte nDisplay, uint16_t * value) {
-  replaceGroup(id, nDisplay, value, DEF_DIGITS, sizeof(DEF_DIGITS));
+void * DisplayManager::newGroup(byte id, byte nDisplay, byte index) {
+  assert(index <= _count);
+
+  if (findGroup(id) != NO_GROUP || !reserveGroups(_count + 1) || !reserveIds(id + 1)
+      || !reserveDisplays(_displays + nDisplay)) {
+    return NULL;
+  }
+
+  // A new group takes the first free slot, and only its slot number is inserted in the
+  // application order: the other groups are not copied
+  byte slot = _count;
+
+  for (byte pos = _count; pos > index; --pos) {
+    _order[pos] = _order[pos - 1];
+  }
+
+  _order[index] = slot;
+  _index[id] = slot;
+  ++_count;
+  _displays += nDisplay;
+  _changed = true;
+
+  updatePeaks(id);
+
+  return &_slots[slot];
 }
 
-void DisplayManager::replaceGroup(byte id, byte nDisplay, uint16_t * value, const byte digits[], byte sizeOfDigits) {
-  assert(digits != NULL && sizeOfDigits == 10);
+void * DisplayManager::renewGroup(byte id, byte nDisplay) {
+  byte slot = findGroup(id);
+
+  if (slot == NO_GROUP) {
+    return NULL;
+  }
+
+  DisplayGroup * group = getGroup(slot);
+  uint16_t displays = _displays - group->getDisplayNumber() + nDisplay;
+
+  if (!reserveDisplays(displays)) {
+    return NULL;
+  }
+
+  group->~DisplayGroup();
+  _displays = displays;
+  _changed = true;
+
+  updatePeaks(id);
 
-  DisplayGroup disGroup(nDisplay, id, value, digits);
-  std::replace_if(_groups.begin(), _groups.end(), std::bind2nd(GroupId(), id), disGroup);
+  return group;
 }
 
 void DisplayManager::removeGroup(byte id) {
-  std::deque<DisplayGroup>::iterator res = std::find_if(_groups.begin(), _groups.end(), std::bind2nd(GroupId(), id));
+  byte slot = findGroup(id);
+
+  if (slot == NO_GROUP) {
+    return;
+  }
+
+  byte last = _count - 1;
+  byte pos = 0;
+
+  while (_order[pos] != slot) {
+    ++pos;
+  }
+
+  for (; pos < last; ++pos) {
+    _order[pos] = _order[pos + 1];
+  }
+
+  _displays -= getGroup(slot)->getDisplayNumber();
+  getGroup(slot)->~DisplayGroup();
+  _index[id] = NO_GROUP;
+
+  // Keep the slots dense: the group in the last slot moves to the free one
+  if (slot != last) {
+    DisplayGroup * moved = getGroup(last);
 
-  if (res != _groups.end()) {
-    _groups.erase(res);
+    new (&_slots[slot]) DisplayGroup(*moved);
+    moved->~DisplayGroup();
+
+    _index[moved->getId()] = slot;
+
+    for (pos = 0; _order[pos] != last; ++pos)
+      ;
+
+    _order[pos] = slot;
   }
+
+  --_count;
+  _changed = true;
 }
 
 void DisplayManager::clearGroups() {
-  _groups.clear();
+  for (byte slot = 0; slot < _count; ++slot) {
+    _index[getGroup(slot)->getId()] = NO_GROUP;
+    getGroup(slot)->~DisplayGroup();
+  }
+
+  _count = 0;
+  _displays = 0;
+  _changed = true;
 }
 
 void DisplayManager::setBitOrder(byte id, byte order) {
   if (order > MSBFIRST)
     return;
 
-  std::deque<DisplayGroup>::iterator res = std::find_if(_groups.begin(), _groups.end(), std::bind2nd(GroupId(), id));
+  byte slot = findGroup(id);
+
+  if (slot != NO_GROUP) {
+    getGroup(slot)->setBitOrder(order);
+  }
+}
+
+void DisplayManager::setChain(byte id, byte chain) {
+  if (chain >= _transport->getLanes() && chain >= _segments)
+    return;
+
+  byte slot = findGroup(id);
 
-  if (res != _groups.end()) {
-    res->setBitOrder(order);
+  if (slot != NO_GROUP && getGroup(slot)->getChain() != chain) {
+    getGroup(slot)->setChain(chain);
+    _changed = true;
+  }
+}
+
+boolean DisplayManager::setSegmentPin(byte segment, byte latchP) {
+  if (_transport->getLanes() > 1 || segment == 0 || segment > _segments
+      || segment >= ShiftTransport::MAX_LANES || latchP == _dimmingPin) {
+    return false;
+  }
+
+  pinMode(latchP, OUTPUT);
+  digitalWrite(latchP, !_outputEnableState);
+
+  _segmentPin[segment] = latchP;
+
+  if (segment == _segments) {
+    ++_segments;
+  }
+
+  return true;
+}
+
+byte DisplayManager::getSegmentCount() const {
+  return _segments;
+}
+
+void DisplayManager::setText(byte id, const char * text) {
+  byte slot = findGroup(id);
+
+  if (slot != NO_GROUP) {
+    getGroup(slot)->setText(text);
+  }
+}
+
+void DisplayManager::setValue(byte id, uint32_t value) {
+  byte slot = findGroup(id);
+
+  if (slot == NO_GROUP) {
+    return;
+  }
+
+  DisplayGroup * group = getGroup(slot);
+
+  // The failures are found again by the render of the whole frame
+  if (!group->setValue(value) || _changed || group->getResult() != 0 || group->isAnimated()) {
+    return;
+  }
+
+  // The layout of the frame is known: render the group in place
+  group->render(_frame + group->getOffset());
+  onGroupRendered(slot);
+}
+
+void DisplayManager::increment(byte id) {
+  count(id, true);
+}
+
+void DisplayManager::decrement(byte id) {
+  count(id, false);
+}
+
+void DisplayManager::count(byte id, boolean up) {
+  byte slot = findGroup(id);
+
+  if (slot == NO_GROUP) {
+    return;
+  }
+
+  DisplayGroup * group = getGroup(slot);
+
+  // Only the digits changed by the carry are written, over a frame already rendered
+  byte * frame = NULL;
+
+  if (!_changed && !group->isChanged() && group->getResult() == 0 && !group->isAnimated()) {
+    frame = _frame + group->getOffset();
+  }
+
+  if (group->count(up, frame) && frame != NULL) {
+    onGroupRendered(slot);
+  }
+}
+
+uint32_t DisplayManager::getCount(byte id) const {
+  byte slot = findGroup(id);
+
+  return slot == NO_GROUP ? 0 : getGroup(slot)->getCount();
+}
+
+void DisplayManager::setCounterMode(byte id, byte mode) {
+  byte slot = findGroup(id);
+
+  if (slot != NO_GROUP) {
+    getGroup(slot)->setCounterMode(mode);
+  }
+}
+
+byte DisplayManager::getDisplayNumber(byte id) const {
+  byte slot = findGroup(id);
+
+  return slot == NO_GROUP ? 0 : getGroup(slot)->getDisplayNumber();
+}
+
+void DisplayManager::showCodes(byte id, const Animation & animation, uint16_t frame) {
+  byte slot = findGroup(id);
+
+  if (slot == NO_GROUP) {
+    return;
+  }
+
+  // The codes are written where the last update laid out the group, the layout is not
+  // changed under a background shift
+  if (_changed) {
+    while (_busy)
+      ;
+
+    renderFrame();
+    _pending = true;
+  }
+
+  DisplayGroup * group = getGroup(slot);
+
+  // The group keeps the frame: a later render of the whole frame writes it again
+  group->setAnimation(&animation, frame);
+
+  if (group->renderAnimation(_frame + group->getOffset())) {
+    _dirtyChains |= 1 << group->getChain();
+    _pending = true;
+  }
+}
+
+void DisplayManager::showValue(byte id) {
+  byte slot = findGroup(id);
+
+  if (slot != NO_GROUP) {
+    getGroup(slot)->setAnimation(NULL, 0);
+  }
+}
+
+boolean DisplayManager::setDimmingPin(byte pin) {
+  if (pin == NO_PIN) {
+    releaseDimmingPin();
+    return true;
+  }
+
+  // The latch pins are toggled by the updates, a PWM on them would be overwritten
+  for (byte k = 0; k < _segments; ++k) {
+    if (pin == _segmentPin[k]) {
+      return false;
+    }
+  }
+
+#ifdef digitalPinToTimer
+  byte timer = digitalPinToTimer(pin);
+
+  if (timer == NOT_ON_TIMER) {
+    return false;
+  }
+
+#if defined(DISPLAYGROUP_MULTIPLEX) && defined(TIMER2A) && defined(TIMER2B)
+  // Timer2 belongs to MultiplexTransport::startTimer
+  if (timer == TIMER2A || timer == TIMER2B) {
+    return false;
+  }
+#endif
+#endif
+
+  releaseDimmingPin();
+
+  _dimmingPin = pin;
+  pinMode(_dimmingPin, OUTPUT);
+  showBrightness();
+
+  return true;
+}
+
+boolean DisplayManager::setBrightness(byte level) {
+  if (_dimmingPin == NO_PIN) {
+    return false;
+  }
+
+  if (level != _brightness) {
+    _brightness = level;
+    showBrightness();
+  }
+
+  return true;
+}
+
+byte DisplayManager::getBrightness() const {
+  return _brightness;
+}
+
+void DisplayManager::releaseDimmingPin() {
+  // The displays are left at full brightness
+  if (_dimmingPin != NO_PIN) {
+    digitalWrite(_dimmingPin, LOW);
+    _dimmingPin = NO_PIN;
+  }
+}
+
+void DisplayManager::showBrightness() {
+  // The output enable of the registers is active low: the longer it is low, the brighter
+  // the displays
+  if (_brightness == 255) {
+    digitalWrite(_dimmingPin, LOW);
+  } else {
+    analogWrite(_dimmingPin, 255 - _brightness);
+  }
+}
+
+void DisplayManager::onGroupRendered(byte slot) {
+  DisplayGroup * group = getGroup(slot);
+
+  if (group->getResult() != 0) {
+    byte pos = 0;
+
+    while (_order[pos] != slot) {
+      ++pos;
+    }
+
+    _lastResult = _count - 1 - pos;
+  }
+
+  _dirtyChains |= 1 << group->getChain();
+  _pending = true;
+}
+
+void DisplayManager::setSequence(byte id, const Sequence * sequence) {
+  byte slot = findGroup(id);
+
+  if (slot != NO_GROUP) {
+    getGroup(slot)->setSequence(sequence);
+  }
+}
+
+void DisplayManager::setSymbols(byte id, byte minus, byte point) {
+  byte slot = findGroup(id);
+
+  if (slot != NO_GROUP) {
+    getGroup(slot)->setSymbols(minus, point);
+    _changed = true;
   }
 }
 
 void DisplayManager::enableGroup(byte id, boolean enable){
-  std::deque<DisplayGroup>::iterator res = std::find_if(_groups.begin(), _groups.end(), std::bind2nd(GroupId(), id));
+  byte slot = findGroup(id);
+
+  if (slot != NO_GROUP) {
+    getGroup(slot)->setEnabled(enable);
+  }
+}
+
+byte DisplayManager::getGroupCount() const {
+  return _count;
+}
+
+byte DisplayManager::getPeakGroups() const {
+  return _peakGroups;
+}
 
-  if (res != _groups.end()) {
-    res->setEnabled(enable);
+uint16_t DisplayManager::getPeakDisplays() const {
+  return _peakDisplays;
+}
+
+uint16_t DisplayManager::getPeakMemory() const {
+  // Group slot and order entry of each group, the id index, the frame buffer and, for
+  // the background shift only, the output buffer
+#ifdef DISPLAYGROUP_ASYNC
+  return _peakGroups * (sizeof(GroupSlot) + 1) + _peakIds + 2 * _peakDisplays;
+#else
+  return _peakGroups * (sizeof(GroupSlot) + 1) + _peakIds + _peakDisplays;
+#endif
+}
+
+void DisplayManager::updatePeaks(byte id) {
+  if (_count > _peakGroups) {
+    _peakGroups = _count;
+  }
+
+  if (id >= _peakIds) {
+    _peakIds = id + 1;
+  }
+
+  if (_displays > _peakDisplays) {
+    _peakDisplays = _displays;
+  }
+}
+
+byte DisplayManager::findGroup(byte id) const {
+  return id < _idCapacity ? _index[id] : NO_GROUP;
+}
+
+DisplayGroup * DisplayManager::getGroup(byte slot) const {
+  return reinterpret_cast<DisplayGroup *>(&_slots[slot]);
+}
+
+boolean DisplayManager::reserveGroups(uint16_t groups) {
+  if (groups <= _groupCapacity) {
+    return true;
+  }
+
+  if (_fixed || groups >= NO_GROUP) {
+    return false;
+  }
+
+  // Doubling the capacity keeps the copies of the groups rare
+  uint16_t capacity = _groupCapacity < 4 ? 4 : 2 * _groupCapacity;
+
+  if (capacity < groups) {
+    capacity = groups;
+  }
+
+  if (capacity >= NO_GROUP) {
+    capacity = NO_GROUP - 1;
+  }
+
+  // The new operator of the AVR core returns NULL when the heap is exhausted
+  GroupSlot * slots = new (std::nothrow) GroupSlot[capacity];
+  byte * order = new (std::nothrow) byte[capacity];
+
+  if (slots == NULL || order == NULL) {
+    delete[] slots;
+    delete[] order;
+    return false;
+  }
+
+  for (byte i = 0; i < _count; ++i) {
+    new (&slots[i]) DisplayGroup(*getGroup(i));
+    getGroup(i)->~DisplayGroup();
+    order[i] = _order[i];
+  }
+
+  delete[] _slots;
+  delete[] _order;
+
+  _slots = slots;
+  _order = order;
+  _groupCapacity = capacity;
+
+  return true;
+}
+
+boolean DisplayManager::reserveIds(uint16_t ids) {
+  if (ids <= _idCapacity) {
+    return true;
+  }
+
+  if (_fixed) {
+    return false;
+  }
+
+  byte * index = new (std::nothrow) byte[ids];
+
+  if (index == NULL) {
+    return false;
+  }
+
+  for (uint16_t id = 0; id < ids; ++id) {
+    index[id] = id < _idCapacity ? _index[id] : NO_GROUP;
+  }
+
+  delete[] _index;
+
+  _index = index;
+  _idCapacity = ids;
+
+  return true;
+}
+
+boolean DisplayManager::reserveDisplays(uint16_t displays) {
+  if (displays <= _displayCapacity) {
+    return true;
+  }
+
+  if (_fixed) {
+    return false;
+  }
+
+  // Only the frame buffer: the output buffer may be in use by a background shift
+  // and it grows in DisplayManager::commit
+  byte * frame = new (std::nothrow) byte[displays];
+
+  if (frame == NULL) {
+    return false;
+  }
+
+  for (uint16_t i = 0; i < _frameSize; ++i) {
+    frame[i] = _frame[i];
   }
+
+  delete[] _frame;
+
+  _frame = frame;
+  _displayCapacity = displays;
+
+  return true;
+}
+
+byte DisplayManager::reverseBits(byte value) {
+  value = (value & 0xF0) >> 4 | (value & 0x0F) << 4;
+  value = (value & 0xCC) >> 2 | (value & 0x33) << 2;
+  value = (value & 0xAA) >> 1 | (value & 0x55) << 1;
+
+  return value;
 }
 
-uint16_t DisplayManager::updateAll() const {
+void DisplayManager::shiftByte(byte value) {
+  _transport->write(value);
+}
+
+ShiftTransport & DisplayManager::getTransport() const {
+  return *_transport;
+}
+
+byte DisplayManager::getOutputEnablePin() const {
+  return _outputEnablePin;
+}
+
+uint16_t DisplayManager::updateAll() {
+  // The changes are shifted out at the end of the batch
+  if (_batchDepth != 0) {
+    return _lastResult;
+  }
+
+  // The output buffer of a committed frame must be latched first
+  while (_busy)
+    ;
+
+  if (renderFrame() || _pending) {
+    _pending = false;
+    shiftFrame();
+  }
+
+  return _lastResult;
+}
+
+uint16_t DisplayManager::forceUpdate() {
+  _changed = true;
+  return updateAll();
+}
+
+void DisplayManager::beginBatch() {
+  ++_batchDepth;
+}
+
+uint16_t DisplayManager::commitBatch() {
+  if (_batchDepth != 0) {
+    --_batchDepth;
+  }
+
+  return updateAll();
+}
+
+uint16_t DisplayManager::commit() {
+  if (_batchDepth != 0) {
+    return _lastResult;
+  }
+
+  // Nothing is rendered while the output buffer is shifted out: the interrupt reads the
+  // chain sizes, which a new layout would change under it. The changes stay pending for
+  // the next commit. The transport may also be shifting the frame of another manager.
+  if (_busy || _transport->isBusy()) {
+    return _lastResult;
+  }
+
+  if (renderFrame()) {
+    _pending = true;
+  }
+
+  if (!_pending) {
+    return _lastResult;
+  }
+
+  _pending = false;
+
+  // The output buffer is needed only by a transport that shifts in background
+#ifdef DISPLAYGROUP_ASYNC
+  boolean background = _transport->getLanes() == 1 && _frameSize != 0 && reserveFront(_frameSize);
+#else
+  boolean background = false;
+#endif
+
+  if (!background) {
+    shiftFrame();
+    return _lastResult;
+  }
+
+  // Double buffering: the next frame can be rendered while this one is shifted out
+  for (uint16_t i = 0; i < _frameSize; ++i) {
+    _front[i] = _frame[i];
+  }
+
+  _busy = true;
+  _shiftMask = _dirtyChains;
+  _dirtyChains = 0;
+
+  shiftSegments();
+
+  return _lastResult;
+}
+
+boolean DisplayManager::isBusy() const {
+  return _busy;
+}
+
+boolean DisplayManager::isPending() const {
+  return _pending;
+}
+
+byte DisplayManager::getLatchCount() const {
+  return _latchCount;
+}
+
+boolean DisplayManager::renderFrame() {
   uint16_t ret = 0, idx = 0;
-  byte outDisable = (outputEnablePinState == HIGH ? LOW : HIGH);
+  const byte * beg;
+  const byte * end = _order;
+  boolean rendered = _changed;
+
+  if (_changed) {
+    // The room has been reserved when the groups were configured
+    _frameSize = _displays;
+    measureChains();
+
+    _dirtyChains = (1 << _chains) - 1;
+  }
+
+  // Each chain has its own region of the frame buffer, in chain order
+  byte * next[ShiftTransport::MAX_LANES];
+  byte * frame = _frame;
+
+  for (byte k = 0; k < _chains; ++k) {
+    next[k] = frame;
+    frame += _chainSize[k];
+  }
 
-  digitalWrite(outputEnablePin, outputEnablePinState);
+  // Render phase: reverse iteration to account for shift register serial update order
+  for (beg = _order + _count; beg != end; --beg, ++idx) {
+    DisplayGroup * group = getGroup(*(beg - 1));
+    byte chain = group->getChain();
 
-  // Reverse iteration to account for shift register serial update order
-  std::deque<DisplayGroup>::const_reverse_iterator beg = _groups.rbegin();
-  std::deque<DisplayGroup>::const_reverse_iterator end = _groups.rend();
+    if (_changed) {
+      group->setOffset(next[chain] - _frame);
+      group->render(next[chain]);
+    } else if (group->renderChanged(next[chain])) {
+      // Each changed group reads its value once, for the check and the render
+      _dirtyChains |= 1 << chain;
+      rendered = true;
+    }
 
-  for (idx = 0; beg != end; ++beg, ++idx) {
-    if ((*beg).update() != 0) {
+    if (group->getResult() != 0) {
       ret = idx;
     }
+
+    next[chain] += group->getDisplayNumber();
   }
 
-  digitalWrite(outputEnablePin, outDisable);
+  if (!rendered) {
+    return false;
+  }
+
+  _changed = false;
+  _lastResult = ret;
 
-  return ret;
+  return true;
+}
+
+void DisplayManager::measureChains() {
+  _chains = 1;
+
+  for (byte k = 0; k < ShiftTransport::MAX_LANES; ++k) {
+    _chainSize[k] = 0;
+  }
+
+  for (byte slot = 0; slot < _count; ++slot) {
+    const DisplayGroup * group = getGroup(slot);
+    byte chain = group->getChain();
+
+    _chainSize[chain] += group->getDisplayNumber();
+
+    if (chain >= _chains) {
+      _chains = chain + 1;
+    }
+  }
+}
+
+void DisplayManager::shiftFrame() {
+  // Another manager may be using the transport in background
+  while (_transport->isBusy())
+    ;
+
+  if (_transport->getLanes() > 1) {
+    digitalWrite(_outputEnablePin, _outputEnableState);
+
+    shiftLanes();
+
+    // Wait for the last byte before the latch
+    _transport->flush();
+
+    digitalWrite(_outputEnablePin, _outputEnableState == HIGH ? LOW : HIGH);
+  } else {
+    // Output phase: stream the segments with a changed group, the whole frame if the
+    // chain is not split
+    for (byte k = 0; k < _chains; ++k) {
+      if (_dirtyChains & (1 << k)) {
+        shiftSegment(_frame, k);
+      }
+    }
+  }
+
+  _dirtyChains = 0;
+  ++_latchCount;
+}
+
+void DisplayManager::shiftSegment(const byte * buffer, byte segment) {
+  const byte * out = buffer + getChainOffset(segment);
+  const byte * outEnd = out + _chainSize[segment];
+
+  digitalWrite(_segmentPin[segment], _outputEnableState);
+
+  for (; out != outEnd; ++out) {
+    _transport->write(*out);
+  }
+
+  // Wait for the last byte before the latch
+  _transport->flush();
+
+  digitalWrite(_segmentPin[segment], _outputEnableState == HIGH ? LOW : HIGH);
+}
+
+void DisplayManager::shiftSegments() {
+  while (_shiftMask != 0) {
+    byte k = 0;
+
+    while (!(_shiftMask & (1 << k))) {
+      ++k;
+    }
+
+    _shiftMask &= ~(1 << k);
+    _shiftSegment = k;
+
+    if (_chainSize[k] != 0) {
+      digitalWrite(_segmentPin[k], _outputEnableState);
+
+      if (_transport->writeAsync(_front + getChainOffset(k), _chainSize[k], &DisplayManager::onFrameShifted, this)) {
+        return;
+      }
+
+      digitalWrite(_segmentPin[k], _outputEnableState == HIGH ? LOW : HIGH);
+    }
+
+    // Nothing to shift in background, or a transport that cannot do it
+    shiftSegment(_front, k);
+  }
+
+  ++_latchCount;
+  _busy = false;
+}
+
+uint16_t DisplayManager::getChainOffset(byte chain) const {
+  uint16_t offset = 0;
+
+  for (byte k = 0; k < chain; ++k) {
+    offset += _chainSize[k];
+  }
+
+  return offset;
+}
+
+void DisplayManager::shiftLanes() {
+  const byte * start[ShiftTransport::MAX_LANES];
+  uint16_t pad[ShiftTransport::MAX_LANES];
+  byte column[ShiftTransport::MAX_LANES];
+  byte lanes = _transport->getLanes();
+  uint16_t longest = 0;
+
+  const byte * frame = _frame;
+
+  for (byte k = 0; k < lanes; ++k) {
+    start[k] = frame;
+
+    if (k < _chains) {
+      frame += _chainSize[k];
+
+      if (_chainSize[k] > longest) {
+        longest = _chainSize[k];
+      }
+    }
+  }
+
+  // The shorter chains are padded at the head: the padding bytes fall off their far end
+  for (byte k = 0; k < lanes; ++k) {
+    pad[k] = longest - (k < _chains ? _chainSize[k] : 0);
+  }
+
+  // One column of bytes, the next byte of every chain, is shifted at each step
+  for (uint16_t col = 0; col < longest; ++col) {
+    for (byte k = 0; k < lanes; ++k) {
+      column[k] = col >= pad[k] ? start[k][col - pad[k]] : 0;
+    }
+
+    _transport->writeLanes(column);
+  }
+}
+
+void DisplayManager::onFrameShifted(void * manager) {
+  DisplayManager * man = static_cast<DisplayManager *>(manager);
+
+  digitalWrite(man->_segmentPin[man->_shiftSegment], man->_outputEnableState == HIGH ? LOW : HIGH);
+
+  // The next segment, if any, is started from the interrupt too
+  man->shiftSegments();
+}
+
+const byte * DisplayManager::getFrame() const {
+  return _frameSize == 0 ? NULL : _frame;
+}
+
+uint16_t DisplayManager::getFrameSize() const {
+  return _frameSize;
+}
+
+boolean DisplayManager::reserveFront(uint16_t displays) {
+  if (displays <= _frontCapacity) {
+    return true;
+  }
+
+  if (_fixed) {
+    return false;
+  }
+
+  delete[] _front;
+
+  _front = new (std::nothrow) byte[displays];
+  _frontCapacity = _front == NULL ? 0 : displays;
+
+  return _front != NULL;
 }
 
 String DisplayManager::printGroups() const {
   String out = "";
-  std::deque<DisplayGroup>::const_iterator beg = _groups.begin();
-  std::deque<DisplayGroup>::const_iterator end = _groups.end();
-
-  uint16_t i = 0;
 
-  for (; beg != end; ++beg, ++i) {
-    out += "Group idx = " + String(i) +  ", # display = " + (*beg).getDisplayNumber() + "\n";
+  for (byte i = 0; i < _count; ++i) {
+    out += "Group idx = " + String(i) +  ", # display = " + getGroup(_order[i])->getDisplayNumber() + "\n";
   }
   return out;
 }
@@ -25,17 +25,49 @@
 
 #include <Arduino.h>
 
+#include <Animation.h>
 #include <DisplayGroup.h>
+#include <ShiftTransport.h>
 
-#include <functional>
-#include <iterator>
-#include <deque>
-#include <algorithm>
+#include <new>
 
 namespace DisplayGroup {
 
 class DisplayGroup;
 
+/**
+ * @brief Raw storage of one DisplayGroup, built in place by the DisplayManager.
+ */
+union GroupSlot {
+  byte data[sizeof(DisplayGroup)];     /**< The group */
+  void * alignPointer;                 /**< Alignment of the pointers in the group */
+  uint32_t alignLong;                  /**< Alignment of the integers in the group */
+};
+
+/**
+ * @brief Raw storage of the BitBangTransport of a DisplayManager, built in place only by
+ * the constructor on data and clock pins.
+ */
+union TransportSlot {
+  byte data[sizeof(BitBangTransport)]; /**< The transport */
+  void * alignPointer;                 /**< Alignment of the pointers in the transport */
+};
+
+/**
+ * @brief Buffers of a DisplayManager with fixed capacity, see StaticDisplayManager.
+ */
+struct GroupPool {
+  GroupSlot * slots;                   /**< Storage of the groups */
+  byte * order;                        /**< Order of the groups, one entry for each slot */
+  byte groups;                         /**< Number of slots, less than 255 */
+  byte * index;                        /**< Slot of each group by id */
+  uint16_t ids;                        /**< Number of ids: valid ids are [0, ids - 1] */
+  byte * frame;                        /**< Frame buffer */
+  byte * front;                        /**< Output buffer of the background shift, NULL without
+                                            DISPLAYGROUP_ASYNC */
+  uint16_t displays;                   /**< Size of the frame and output buffers */
+};
+
 /**
  * @brief Manager for display groups. Add, remove, print and update all the displays at once.
  *
@@ -47,16 +79,33 @@ class DisplayGroup;
  * This class holds an array of groups, which in turn is an array of display, and update the
  * whole array when requested. The update executes in reverse order, to account for the serial
  * hardware link between the shift registers.
+ * The groups are found by id in constant time, through an index from id to slot.
+ * The groups are built in place in an array of slots, and the application order is an array
+ * of slot numbers: reordering the groups never copies them. A group is copied only when
+ * the slots are reallocated to grow, and when removeGroup moves the group of the last slot
+ * in the free one to keep the slots dense. The buffers grow on the heap as groups are
+ * added, or they are supplied at compile time by StaticDisplayManager, which never allocates
+ * and makes addGroup, insertGroup and replaceGroup fail when its capacity is exhausted.
+ * The pins, the transport and the output enable state belong to each manager, so several
+ * managers, e.g. on separate chains, can be updated one after the other in any order.
+ * Managers sharing a transport that shifts in background wait for each other.
  * The update can be done with latch pin low, and after the shift the latch pin is taken high,
  * or with high output enable and transition to low on update. This is configurable through
  * outputEnableState parameter on the constructor.
  * LOW works with typical 74HC595 shift register.
- *
- * This class uses the STL library for Arduino, which can be found at
- * @htmlonly
- * <a href="http://andybrown.me.uk/wk/2011/01/15/the-standard-template-library-stl-for-avr-with-c-streams/">
- * the-standard-template-library-stl-for-avr-with-c-streams </a>
- * @endhtmlonly
+ * The bytes are shifted out through a ShiftTransport: BitBangTransport toggles any pair of
+ * digital pins, SpiTransport uses the hardware SPI peripheral on the MOSI and SCK pins.
+ * ParallelTransport drives up to 8 chains sharing the clock, each with its own data pin on
+ * the same port: every group is assigned to a chain (DisplayManager::setChain) and all the
+ * chains are shifted at once, so the refresh time is that of the longest chain.
+ * MultiplexTransport drives the displays without a shift register each: the frame is the
+ * buffer of a multiplexed refresh, one display lit at a time by a timer interrupt.
+ * With a transport of one lane the chains can be segments instead: independent shift
+ * register chains sharing the data and clock pins, each with its own latch pin
+ * (DisplayManager::setSegmentPin). Only the segments holding a changed group are shifted
+ * out and latched, the others keep showing their last frame.
+ * A group can show the frames of an Animation instead of its value: an Animator plays
+ * blink, scroll, marquee and fade sequences, writing only the codes that change.
  *
  * @author Gionata Boccalini
  * @date   May 13, 2014
@@ -66,13 +115,35 @@ public:
 
   static const byte DEF_DIGITS[10];                 /**< Default digits code for small common cathode 7-segments display */
   static const byte DEF_ORDER;                      /**< Default bit order for the shift */
+  static const byte DEF_MINUS;                      /**< Default minus code, the middle segment of DEF_DIGITS */
+  static const byte DEF_POINT;                      /**< Default decimal point code, the segment unused by DEF_DIGITS */
   static const byte DEF_OUTPUT_ENABLE_W_STATE;      /**< Default logical state (HIGH or LOW) of the output enable (or latch) pin during
                                                          shift register update */
 
-  static byte dataPin;                              /**< Default data output pin */
-  static byte clockPin;                             /**< Default clock output pin */
-  static byte outputEnablePin;                      /**< Default "output enable" output pin */
-  static byte outputEnablePinState;                 /**< Logical state (HIGH or LOW) of the output enable to select a shift register */
+  /**
+   * @param[in] value       A 7-segments code
+   * @return The code with the bit order reversed, i.e. the byte that shifted out MSB first
+   *         puts the segments in the same place as value shifted out LSB first
+   */
+  static byte reverseBits(byte value);
+
+  /**
+   * Shift out one byte to the shift register chain, most significant bit first, through
+   * the transport of the manager. The byte may still be in transit when the method returns.
+   *
+   * @param[in] value       The byte to shift out
+   */
+  void shiftByte(byte value);
+
+  /**
+   * @return The transport of the manager, e.g. to shift out a Display on the same chain.
+   */
+  ShiftTransport & getTransport() const;
+
+  /**
+   * @return The output enable (or latch) pin of the manager.
+   */
+  byte getOutputEnablePin() const;
 
   /**
    * Constructor.
@@ -85,6 +156,17 @@ public:
    */
   DisplayManager(byte dataP, byte clockP, byte outputEnableP, byte outputEnableState);
 
+  /**
+   * Constructor with a user supplied transport, e.g. SpiTransport to shift the chain
+   * with the hardware SPI peripheral. The transport must outlive the manager.
+   *
+   * @param[in] transport           Transport used to shift out the bytes
+   * @param[in] outputEnableP       Arduino output enable pin for shift register
+   * @param[in] outputEnableState   Logical state (HIGH or LOW) of the output enable (or latch) pin during
+   *                                shift register update
+   */
+  DisplayManager(ShiftTransport & transport, byte outputEnableP, byte outputEnableState);
+
   /** Default destructor.
    */
   virtual ~DisplayManager();
@@ -94,21 +176,49 @@ public:
    * by value is used during the update of the display. Uses default digits code.
    * @param[in] id          Unique Id of the group
    * @param[in] nDisplay    Number of display contained in the group.
-   * @param[in] value       Address of the variable to watch
+   * @param[in] value       Address and format of the variable to watch, see Value
+   * @return True on success, false if the id is already used or the capacity of the
+   *         manager is exhausted: nothing is allocated in that case
    */
-  void addGroup(byte id, byte nDisplay,uint16_t * value);
+  boolean addGroup(byte id, byte nDisplay, const Value & value);
 
   /**
    * Add a display group at the end of the data container. The variable pointed to
    * by value is used during the update of the display.
    * @param[in] id          Unique Id of the group
    * @param[in] nDisplay    Number of display contained in the group.
-   * @param[in] value       Address of the variable to watch
+   * @param[in] value       Address and format of the variable to watch, see Value
    * @param[in] digits[]    Array of segment code to initialize all the display in
    *                        the group.
-   * @param[in] sizeOfDigits Size of the digits code display
+   * @param[in] sizeOfDigits Size of the digits code display, at least DisplayGroup::DIGITS_SIZE
+   * @return True on success, false if the id is already used or the capacity of the
+   *         manager is exhausted: nothing is allocated in that case
    */
-  void addGroup(byte id, byte nDisplay, uint16_t * value, const byte digits[], byte sizeOfDigits);
+  boolean addGroup(byte id, byte nDisplay, const Value & value, const byte digits[], byte sizeOfDigits);
+
+  /**
+   * Add a display group at the end of the data container, with the given font, e.g.
+   * Font::ascii to show a text or Font::digits to keep the digits codes in flash.
+   * @param[in] id          Unique Id of the group
+   * @param[in] nDisplay    Number of display contained in the group.
+   * @param[in] value       Address and format of the variable to watch, or text, see Value
+   * @param[in] font        7-segments codes of the digits and of the characters
+   * @return As DisplayManager::addGroup
+   */
+  boolean addGroup(byte id, byte nDisplay, const Value & value, const Font & font);
+
+  /**
+   * Add a display group of N displays at the end of the data container. The number of
+   * displays is fixed at compile time: the group does not allocate any memory and the
+   * conversion of its value is fully unrolled.
+   * @param[in] id          Unique Id of the group
+   * @param[in] value       Address of the variable to watch
+   * @param[in] digits[]    Array of segment code [0-9] to initialize all the display in
+   *                        the group.
+   * @return As DisplayManager::addGroup
+   */
+  template <byte N>
+  boolean addGroup(byte id, uint16_t * value, const byte digits[] = DEF_DIGITS);
 
   /**
    * Add group to the DisplayManager. The group is inserted in the correct order,
@@ -117,9 +227,11 @@ public:
    * @param[in] id          Unique Id of the group
    * @param[in] nDisplay	Number of display contained in the group
    * @param[in] index		Index for the group in the application
-   * @param[in] value		Address of the variable to watch
+   * @param[in] value		Address and format of the variable to watch, see Value
+   * @return True on success, false if the id is already used or the capacity of the
+   *         manager is exhausted: nothing is allocated in that case
    */
-  void insertGroup(byte id, byte nDisplay, byte index, uint16_t * value);
+  boolean insertGroup(byte id, byte nDisplay, byte index, const Value & value);
 
   /**
    * Add group to the DisplayManager. The group is inserted in the correct order,
@@ -128,39 +240,97 @@ public:
    * @param[in] id          Unique Id of the group
    * @param[in] nDisplay    Number of display contained in the group
    * @param[in] index       Index for the group in the application
-   * @param[in] value       Address of the variable to watch
+   * @param[in] value       Address and format of the variable to watch, see Value
    * @param[in] digits[]    Array of segment code to initialize all the display in
    *                        the group.
-   * @param[in] sizeOfDigits Size of the digits code display
+   * @param[in] sizeOfDigits Size of the digits code display, at least DisplayGroup::DIGITS_SIZE
+   * @return True on success, false if the id is already used or the capacity of the
+   *         manager is exhausted: nothing is allocated in that case
+   */
+  boolean insertGroup(byte id, byte nDisplay, byte index, const Value & value, const byte digits[], byte sizeOfDigits);
+
+  /**
+   * Add group to the DisplayManager at the given index, with the given font, see
+   * DisplayManager::addGroup.
+   * @param[in] id          Unique Id of the group
+   * @param[in] nDisplay    Number of display contained in the group
+   * @param[in] index       Index for the group in the application
+   * @param[in] value       Address and format of the variable to watch, or text, see Value
+   * @param[in] font        7-segments codes of the digits and of the characters
+   * @return As DisplayManager::insertGroup
+   */
+  boolean insertGroup(byte id, byte nDisplay, byte index, const Value & value, const Font & font);
+
+  /**
+   * Add a group of N displays to the DisplayManager, at the given index. The number of
+   * displays is fixed at compile time, see DisplayManager::addGroup<N>.
+   * @param[in] id          Unique Id of the group
+   * @param[in] index       Index for the group in the application
+   * @param[in] value       Address of the variable to watch
+   * @param[in] digits[]    Array of segment code [0-9] to initialize all the display in
+   *                        the group.
+   * @return As DisplayManager::addGroup
    */
-  void insertGroup(byte id, byte nDisplay, byte index, uint16_t * value, const byte digits[], byte sizeOfDigits);
+  template <byte N>
+  boolean insertGroup(byte id, byte index, uint16_t * value, const byte digits[] = DEF_DIGITS);
 
 
   /**
    * Replace a group with the one built from the given parameters. The group is
    * inserted in the correct order, given the index. The variable pointed to by
-   * value is used during the update of the display.
+   * value is used during the update of the display. Nothing is built if there
+   * is no group with this id.
    * @param[in] id          Unique Id of the group to be replaced
    * @param[in] nDisplay    Number of display contained in the group
-   * @param[in] value       Address of the variable to watch
+   * @param[in] value       Address and format of the variable to watch, see Value
+   * @return True on success, false if there is no group with this id or the capacity
+   *         of the manager is exhausted: the group is left unchanged in that case
    */
-  void replaceGroup(byte id, byte nDisplay, uint16_t * value);
+  boolean replaceGroup(byte id, byte nDisplay, const Value & value);
 
   /**
    * Replace a group with the one built from the given parameters. The group is
    * inserted in the correct order, given the index. The variable pointed to by
-   * value is used during the update of the display.
+   * value is used during the update of the display. Nothing is built if there
+   * is no group with this id.
    * @param[in] id          Unique Id of the group to be replaced
    * @param[in] nDisplay    Number of display contained in the group
-   * @param[in] value       Address of the variable to watch
+   * @param[in] value       Address and format of the variable to watch, see Value
    * @param[in] digits      Array of segment code to initialize all the display in
    *                        the group.
-   * @param[in] sizeOfDigits Size of the digits code display
+   * @param[in] sizeOfDigits Size of the digits code display, at least DisplayGroup::DIGITS_SIZE
+   * @return True on success, false if there is no group with this id or the capacity
+   *         of the manager is exhausted: the group is left unchanged in that case
+   */
+  boolean replaceGroup(byte id, byte nDisplay, const Value & value, const byte digits[], byte sizeOfDigits);
+
+  /**
+   * Replace a group with the one built from the given parameters, with the given font,
+   * see DisplayManager::replaceGroup.
+   * @param[in] id          Unique Id of the group to be replaced
+   * @param[in] nDisplay    Number of display contained in the group
+   * @param[in] value       Address and format of the variable to watch, or text, see Value
+   * @param[in] font        7-segments codes of the digits and of the characters
+   * @return As DisplayManager::replaceGroup
+   */
+  boolean replaceGroup(byte id, byte nDisplay, const Value & value, const Font & font);
+
+  /**
+   * Replace a group with a group of N displays, built from the given parameters. The
+   * number of displays is fixed at compile time, see DisplayManager::addGroup<N>.
+   * @param[in] id          Unique Id of the group to be replaced
+   * @param[in] value       Address of the variable to watch
+   * @param[in] digits[]    Array of segment code [0-9] to initialize all the display in
+   *                        the group.
+   * @return As DisplayManager::replaceGroup
    */
-  void replaceGroup(byte id, byte nDisplay, uint16_t * value, const byte digits[], byte sizeOfDigits);
+  template <byte N>
+  boolean replaceGroup(byte id, uint16_t * value, const byte digits[] = DEF_DIGITS);
 
   /**
-   * Remove a group from the manager
+   * Remove a group from the manager. To keep the slots dense, the group of the last slot
+   * is copied in the slot of the removed group: the only copy of a configured group
+   * besides the growth of the slots.
    * @param[in] id		    Unique Id of the group
    */
   void removeGroup(byte id);
@@ -182,9 +352,85 @@ public:
 
   /**
    * Update all the display group in the manager.
+   * The update runs in two phases: every group is first rendered in the frame buffer,
+   * in the order of the shift register chain, then the whole frame is streamed to the
+   * transport in one loop.
+   * Only the groups whose value, enable flag or bit order changed are rendered again: when
+   * nothing changed since the last update the method returns immediately, without shifting
+   * the chain and without toggling the output enable pin.
+   * @return The index of the DisplayGroup with a failure in the update.
+   */
+  uint16_t updateAll();
+
+  /**
+   * Render all the groups and shift out the whole chain, even if nothing changed, e.g. to
+   * recover from a glitch on the shift register chain.
+   * @return The index of the DisplayGroup with a failure in the update.
+   */
+  uint16_t forceUpdate();
+
+  /**
+   * Start a batch of changes: until the matching DisplayManager::commitBatch the groups
+   * can be added, replaced, enabled and configured, and DisplayManager::updateAll,
+   * DisplayManager::forceUpdate and DisplayManager::commit only record that an update is
+   * due, without rendering nor shifting anything. Batches can be nested, e.g. by modules
+   * that each update their own groups.
+   */
+  void beginBatch();
+
+  /**
+   * End a batch of changes started by DisplayManager::beginBatch. The end of the outermost
+   * batch updates the displays once, as DisplayManager::updateAll: nothing is shifted out
+   * when nothing changed, so a repeated commit costs nothing.
+   * @return The index of the DisplayGroup with a failure in the update.
+   */
+  uint16_t commitBatch();
+
+  /**
+   * Update all the display group in the manager without waiting for the shift register
+   * chain. The changed groups are rendered in the frame buffer (the back buffer), which
+   * is then copied in the output buffer (the front buffer) and shifted out in background
+   * by the transport, see ShiftTransport::writeAsync. The output enable (or latch) pin is
+   * toggled only when the whole frame has been shifted out, from the interrupt; the latch
+   * pin of each segment when the segment has been shifted out.
+   * If the previous frame is still being shifted out nothing is rendered: the changes are
+   * kept pending and rendered and sent by a later call. Transports that cannot work in background, or a library built
+   * without DISPLAYGROUP_ASYNC, shift out the frame before returning.
    * @return The index of the DisplayGroup with a failure in the update.
    */
-  uint16_t updateAll() const;
+  uint16_t commit();
+
+  /**
+   * @return True while a frame started by DisplayManager::commit is being shifted out.
+   */
+  boolean isBusy() const;
+
+  /**
+   * @return True if a frame rendered by DisplayManager::commit has not been sent yet,
+   *         because the previous frame was still being shifted out, or if a value pushed
+   *         by DisplayManager::setValue has not been sent yet.
+   */
+  boolean isPending() const;
+
+  /**
+   * Counter of the latched frames, incremented each time the output enable (or latch) pin
+   * is toggled at the end of a frame. Poll it to know when a committed frame is on the
+   * displays. The counter wraps around.
+   * @return The number of frames latched.
+   */
+  byte getLatchCount() const;
+
+  /**
+   * @return The frame buffer filled by the last DisplayManager::updateAll: one 7-segments
+   *         code for each display, in the order the bytes are shifted out. With more than
+   *         one chain, the displays of chain 0 come first, then those of chain 1 and so on.
+   */
+  const byte * getFrame() const;
+
+  /**
+   * @return The number of bytes in the frame buffer, i.e. the number of displays in the chain.
+   */
+  uint16_t getFrameSize() const;
 
   /**
    * Sets the update byte order in the group given by index.
@@ -193,18 +439,434 @@ public:
    */
   void setBitOrder(byte id, byte order);
 
+  /**
+   * @return The number of groups in the manager.
+   */
+  byte getGroupCount() const;
+
+  /**
+   * @return The highest number of groups configured at the same time.
+   */
+  byte getPeakGroups() const;
+
+  /**
+   * @return The highest number of displays configured at the same time.
+   */
+  uint16_t getPeakDisplays() const;
+
+  /**
+   * Peak memory used by the configuration: the group slots, the id index, the frame
+   * buffer and, with DISPLAYGROUP_ASYNC, the output buffer, in bytes. Use it, with DisplayManager::getPeakGroups and
+   * DisplayManager::getPeakDisplays, to size a StaticDisplayManager. The heap buffers of a
+   * DisplayManager may be larger, since they grow in steps.
+   * @return The peak memory used, in bytes.
+   */
+  uint16_t getPeakMemory() const;
+
+  /**
+   * Assign the group given by id to a chain. Groups on different chains are shifted at
+   * the same time by a transport with more than one lane, e.g. ParallelTransport: the
+   * group order of each chain is the order of the groups in the manager. All the groups
+   * are on chain 0 by default. With a transport of one lane the chain is a segment, see
+   * DisplayManager::setSegmentPin.
+   * @param[in] id         Unique Id of the group
+   * @param[in] chain      The chain, less than ShiftTransport::getLanes of the transport
+   *                       or than DisplayManager::getSegmentCount
+   */
+  void setChain(byte id, byte chain);
+
+  /**
+   * Split the chain in segments: give the segment its own latch pin, and put groups on it
+   * with DisplayManager::setChain. The segments share the data and clock pins, so the
+   * bytes of a segment reach the shift registers of all of them, but only the segment
+   * whose latch pin is toggled shows them: an update shifts out and latches only the
+   * segments with a changed group. Segment 0 is latched by the output enable pin given
+   * to the constructor. Segments work with a transport of one lane only, and the pin must
+   * drive the latch (storage clock) of the shift registers, not their output enable.
+   * @param[in] segment    The segment, in [1, ShiftTransport::MAX_LANES - 1]. Segments are
+   *                       numbered in order: at most one more than the segments configured
+   * @param[in] latchP     Arduino latch pin of the segment
+   * @return True on success, false if the transport has more than one lane or the segment
+   *         is out of range
+   */
+  boolean setSegmentPin(byte segment, byte latchP);
+
+  /**
+   * @return The number of segments of the chain, 1 if it is not split.
+   */
+  byte getSegmentCount() const;
+
+  /**
+   * Show a text in the group given by id, instead of its value, with the font of the group:
+   * the group is rendered at the next update. Call it again after changing the characters
+   * of the same string.
+   * @param[in] id         Unique Id of the group
+   * @param[in] text       The string to show, it must outlive the group
+   */
+  void setText(byte id, const char * text);
+
+  /**
+   * Push the value of the group given by id, instead of watching a variable: the value is
+   * stored in the group, see Value, and its 7-segments codes are rendered in the frame
+   * buffer right away, so the next DisplayManager::updateAll or DisplayManager::commit
+   * only shifts out the frame, without reading nor converting the group. Pushing the
+   * value shown does nothing. When the groups have been configured since the last update,
+   * or the group failed its last render, the group is rendered by the next update instead.
+   * Not to be called from an interrupt.
+   * @param[in] id         Unique Id of the group
+   * @param[in] value      The value, converted in the format of the group: signed values
+   *                       are sign extended to 32 bits, a Value::CLOCK group takes the
+   *                       elapsed time and moves its digits by ticks, see
+   *                       DisplayGroup::setClock
+   */
+  void setValue(byte id, uint32_t value);
+
+  /**
+   * Count one up in the Value::COUNTER group given by id. The counter is kept in decimal
+   * digits, so the carry ripples through the digits without any conversion, and only the
+   * changed digits are written in the frame buffer, as DisplayManager::setValue does; a
+   * counter is set to any value with DisplayManager::setValue. Groups of another type are
+   * not changed.
+   * @param[in] id         Unique Id of the group
+   */
+  void increment(byte id);
+
+  /**
+   * Count one down in the Value::COUNTER group given by id, see DisplayManager::increment.
+   * @param[in] id         Unique Id of the group
+   */
+  void decrement(byte id);
+
+  /**
+   * @param[in] id         Unique Id of the group
+   * @return The count of the Value::COUNTER group given by id, 0 if there is no such group
+   */
+  uint32_t getCount(byte id) const;
+
+  /**
+   * Sets what the Value::COUNTER group given by id does when it counts past its digits:
+   * the default DisplayGroup::COUNTER_OVERFLOW keeps counting and fails the update with
+   * -3 when the count does not fit in the displays, as a watched value does.
+   * @param[in] id         Unique Id of the group
+   * @param[in] mode       A DisplayGroup::CounterMode
+   */
+  void setCounterMode(byte id, byte mode);
+
+  /**
+   * @param[in] id         Unique Id of the group
+   * @return The number of displays of the group given by id, 0 if there is no such group
+   */
+  byte getDisplayNumber(byte id) const;
+
+  /**
+   * Show a frame of an animation in the group given by id, instead of its value, until
+   * DisplayManager::showValue. The codes are compared with the frame buffer and only the
+   * differing ones are written: when none differs, the next update shifts out nothing.
+   * When the groups have been configured since the last update the frame is rendered first.
+   * The group keeps showing the frame through the renders of the whole frame, e.g. by
+   * DisplayManager::forceUpdate. Not to be called from an interrupt.
+   * @param[in] id         Unique Id of the group
+   * @param[in] animation  The codes of the animation, they must outlive the frame shown
+   * @param[in] frame      The frame to show, see Animation::getFrameCount
+   */
+  void showCodes(byte id, const Animation & animation, uint16_t frame);
+
+  /**
+   * Show the value of the group given by id again, after DisplayManager::showCodes: the
+   * group is rendered at the next update. Nothing is done if the group shows its value.
+   * @param[in] id         Unique Id of the group
+   */
+  void showValue(byte id);
+
+  /**
+   * Sets the pin that dims the displays: a PWM capable pin wired to the output enable
+   * (active low) of all the shift registers, not to their latch. The updates never toggle
+   * it, so the strobe of the latch pins is not changed by the brightness. The pin is driven
+   * at the brightness of the manager at once.
+   * With DISPLAYGROUP_MULTIPLEX the PWM pins of Timer2 (3 and 11 on the atmega328p) are
+   * rejected: the timer is taken by MultiplexTransport::startTimer.
+   * @param[in] pin        The pin, 0xFF for none
+   * @return False if the pin is the output enable (or latch) pin of the manager or of a
+   *         segment, if it has no PWM, or if its timer is taken by the library
+   */
+  boolean setDimmingPin(byte pin);
+
+  /**
+   * Sets the brightness of all the displays, with a PWM on the dimming pin, see
+   * DisplayManager::setDimmingPin. The brightness is kept through the updates.
+   * @param[in] level      The brightness, from 0 (off) to 255 (full, no PWM)
+   * @return False if the manager has no dimming pin
+   */
+  boolean setBrightness(byte level);
+
+  /**
+   * @return The brightness of the displays, see DisplayManager::setBrightness
+   */
+  byte getBrightness() const;
+
+  /**
+   * Sets the sequence counter of the value watched by the group given by id, when the
+   * value is written by an interrupt: each update takes one consistent snapshot of the
+   * value, read again if the interrupt bumped the counter during the read, instead of
+   * disabling the interrupts. Groups can share a counter.
+   * @param[in] id         Unique Id of the group
+   * @param[in] sequence   The counter bumped by the writer, see Sequence, NULL to remove it
+   */
+  void setSequence(byte id, const Sequence * sequence);
+
+  /**
+   * Sets the codes of the minus and of the decimal point in the group given by id, see
+   * DisplayGroup::setSymbols.
+   * @param[in] id         Unique Id of the group
+   * @param[in] minus      7-segments code of the minus
+   * @param[in] point      7-segments code of the decimal point
+   */
+  void setSymbols(byte id, byte minus, byte point);
+
   /**
    * Prints the vector of groups in a string object.
    * @return The string representation of the vector of groups.
    */
   String printGroups() const;
 
+protected:
+
+  /**
+   * Use the given buffers instead of the heap. Called once by StaticDisplayManager, before
+   * any group is added: from then on the capacity of the manager is fixed.
+   * @param[in] pool        The buffers
+   */
+  void usePool(const GroupPool & pool);
+
 private:
 
-  std::deque<DisplayGroup> _groups; /**< Deque of display group */
+  /**
+   * Not copyable: the manager owns its buffers.
+   */
+  DisplayManager(const DisplayManager &);
+  DisplayManager & operator =(const DisplayManager &);
+
+  /**
+   * Initialize the state of the manager, with no buffers.
+   */
+  void init();
+
+  /**
+   * Configure the output enable pin and start the transport.
+   */
+  void setup();
+
+  /**
+   * Render the changed groups in the frame buffer, see DisplayManager::updateAll.
+   * @return True if the frame buffer changed since the last update
+   */
+  boolean renderFrame();
+
+  /**
+   * Shift out the frame buffer and latch it, waiting for the transport.
+   */
+  void shiftFrame();
+
+  /**
+   * Drive the dimming pin at the brightness of the manager.
+   */
+  void showBrightness();
+
+  /**
+   * Stop the PWM of the dimming pin, if any, and forget it.
+   */
+  void releaseDimmingPin();
+
+  /**
+   * Compute the number of displays of every chain, after a configuration change.
+   */
+  void measureChains();
+
+  /**
+   * Shift out all the chains at once through a transport with more than one lane.
+   */
+  void shiftLanes();
+
+  /**
+   * Shift out one segment of a buffer and latch it, waiting for the transport.
+   * @param[in] buffer      The frame or the output buffer
+   * @param[in] segment     The segment
+   */
+  void shiftSegment(const byte * buffer, byte segment);
+
+  /**
+   * Shift out the next segment of the output buffer in background, or latch the frame when
+   * all the segments have been shifted out. Called by DisplayManager::commit and from the
+   * interrupt.
+   */
+  void shiftSegments();
+
+  /**
+   * @param[in] chain       A chain
+   * @return The position of the chain in the frame buffer
+   */
+  uint16_t getChainOffset(byte chain) const;
+
+  /**
+   * Count one up or down in a counter group, see DisplayManager::increment.
+   * @param[in] id          Unique Id of the group
+   * @param[in] up          True to count up
+   */
+  void count(byte id, boolean up);
+
+  /**
+   * The group in the given slot has been rendered in place, outside of the update of the
+   * whole frame: the frame must be shifted out.
+   * @param[in] slot        The slot of the group
+   */
+  void onGroupRendered(byte slot);
+
+  /**
+   * Latch the segment shifted out in background and start the next one, called from the
+   * interrupt.
+   * @param[in] manager     The DisplayManager that committed the frame
+   */
+  static void onFrameShifted(void * manager);
+
+  /**
+   * Reserve the room for a new group and link it at the given index. The caller must
+   * build the group in the returned slot right away.
+   * @param[in] id          Unique Id of the group
+   * @param[in] nDisplay    Number of display contained in the group
+   * @param[in] index       Index for the group in the application
+   * @return The slot of the new group, NULL if the id is already used or there is no room
+   */
+  void * newGroup(byte id, byte nDisplay, byte index);
+
+  /**
+   * Destroy the group with the given id, to build its replacement in the same slot. The
+   * caller must build the group in the returned slot right away.
+   * @param[in] id          Unique Id of the group
+   * @param[in] nDisplay    Number of display of the replacement
+   * @return The slot of the group, NULL if there is no such group or no room
+   */
+  void * renewGroup(byte id, byte nDisplay);
+
+  /**
+   * @param[in] id          Unique Id of the group
+   * @return The slot of the group, DisplayManager::NO_GROUP if there is no group with this id
+   */
+  byte findGroup(byte id) const;
+
+  /**
+   * @param[in] slot        A used slot
+   * @return The group built in the slot
+   */
+  DisplayGroup * getGroup(byte slot) const;
+
+  /**
+   * Update the peak counters after a configuration change.
+   * @param[in] id          Id of the group configured
+   */
+  void updatePeaks(byte id);
+
+  /**
+   * Make room for the given number of groups. A manager with fixed capacity only checks
+   * the room, the others grow their heap buffers, see DisplayManager::usePool.
+   * @param[in] groups      Number of groups
+   * @return True if there is room
+   */
+  boolean reserveGroups(uint16_t groups);
+
+  /**
+   * Make room in the id index for the ids [0, ids - 1], see DisplayManager::reserveGroups.
+   * @param[in] ids         Number of ids
+   * @return True if there is room
+   */
+  boolean reserveIds(uint16_t ids);
+
+  /**
+   * Make room in the frame buffer, see DisplayManager::reserveGroups.
+   * @param[in] displays    Number of displays
+   * @return True if there is room
+   */
+  boolean reserveDisplays(uint16_t displays);
+
+  /**
+   * Make room in the output buffer, only when no frame is being shifted out in background.
+   * @param[in] displays    Number of displays
+   * @return True if there is room
+   */
+  boolean reserveFront(uint16_t displays);
+
+  static const byte NO_GROUP = 0xFF;   /**< Slot of a missing group, also the maximum number of groups */
+  static const byte NO_PIN = 0xFF;     /**< No dimming pin */
+
+  GroupSlot * _slots;                  /**< Storage of the groups, the first _count are used */
+  byte * _order;                       /**< Slot of the group at each position in the application */
+  byte * _index;                       /**< Slot of each group by id */
+  byte * _frame;                       /**< Frame buffer, in shift register chain order */
+  byte _groupCapacity;                 /**< Number of slots */
+  uint16_t _idCapacity;                /**< Number of entries of the id index */
+  uint16_t _displayCapacity;           /**< Size of the frame buffer */
+  uint16_t _frontCapacity;             /**< Size of the output buffer */
+  boolean _fixed;                      /**< True when the buffers cannot grow, see DisplayManager::usePool */
+
+  byte _count;                         /**< Number of groups */
+  uint16_t _displays;                  /**< Number of displays of all the groups */
+  uint16_t _frameSize;                 /**< Number of displays in the last rendered frame */
+  byte _chains;                        /**< Number of chains used, the highest chain plus one */
+  uint16_t _chainSize[ShiftTransport::MAX_LANES]; /**< Number of displays of each chain */
+  byte _dirtyChains;                   /**< Chains rendered since the last shift, one bit each */
+  byte _segments;                      /**< Number of segments, see DisplayManager::setSegmentPin */
+  byte _segmentPin[ShiftTransport::MAX_LANES]; /**< Latch pin of each segment */
+  byte _peakGroups;                    /**< Highest number of groups */
+  uint16_t _peakIds;                   /**< Highest id used plus one */
+  uint16_t _peakDisplays;              /**< Highest number of displays */
+  boolean _changed;                    /**< True when the groups in the manager changed */
+  byte _batchDepth;                    /**< Number of open batches, see DisplayManager::beginBatch */
+  uint16_t _lastResult;                /**< Return value of the last update */
+
+  byte * _front;                       /**< Output buffer of the background shift */
+  boolean _pending;                    /**< True when the frame buffer has not been committed yet */
+  volatile boolean _busy;              /**< True while the output buffer is being shifted out */
+  volatile byte _latchCount;           /**< Number of frames latched */
+  volatile byte _shiftMask;            /**< Segments of the output buffer not shifted out yet */
+  volatile byte _shiftSegment;         /**< Segment being shifted out in background */
+  byte _outputEnablePin;               /**< Output enable (or latch) pin */
+  byte _outputEnableState;             /**< Logical state (HIGH or LOW) of the output enable pin during the update */
+  byte _dimmingPin;                    /**< Output enable pin of the registers dimmed by a PWM, NO_PIN for none */
+  byte _brightness;                    /**< Brightness of the displays, 255 for full */
+  TransportSlot _bitBang;              /**< Software transport on the data and clock pins, built by the
+                                            constructor on pins only */
+  ShiftTransport * _transport;         /**< Transport used to shift out the bytes */
 
 };
 
+template <byte N>
+boolean DisplayManager::addGroup(byte id, uint16_t * value, const byte digits[]) {
+  return insertGroup<N>(id, _count, value, digits);
+}
+
+template <byte N>
+boolean DisplayManager::insertGroup(byte id, byte index, uint16_t * value, const byte digits[]) {
+  void * slot = newGroup(id, N, index);
+
+  if (slot == NULL) {
+    return false;
+  }
+
+  new (slot) DisplayGroup(N, id, value, digits, &DisplayGroup::renderFixed<N>);
+  return true;
+}
+
+template <byte N>
+boolean DisplayManager::replaceGroup(byte id, uint16_t * value, const byte digits[]) {
+  void * slot = renewGroup(id, N);
+
+  if (slot == NULL) {
+    return false;
+  }
+
+  new (slot) DisplayGroup(N, id, value, digits, &DisplayGroup::renderFixed<N>);
+  return true;
+}
+
 } /* namespace DisplayGroup */
 
 #endif /* DISPLAYMANAGER_H_ */
@@ -0,0 +1,169 @@
+/*
+ *  This file is part of DisplayGroup Library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ */
+
+
+#include "Font.h"
+
+namespace DisplayGroup {
+
+// Segments of DisplayManager::DEF_DIGITS
+static const byte SEG_A = 8;
+static const byte SEG_B = 16;
+static const byte SEG_C = 64;
+static const byte SEG_D = 32;
+static const byte SEG_E = 1;
+static const byte SEG_F = 4;
+static const byte SEG_G = 2;
+static const byte SEG_P = 128;
+
+const byte FONT_DIGITS[10] PROGMEM = { SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F,
+                                       SEG_B | SEG_C,
+                                       SEG_A | SEG_B | SEG_D | SEG_E | SEG_G,
+                                       SEG_A | SEG_B | SEG_C | SEG_D | SEG_G,
+                                       SEG_B | SEG_C | SEG_F | SEG_G,
+                                       SEG_A | SEG_C | SEG_D | SEG_F | SEG_G,
+                                       SEG_A | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G,
+                                       SEG_A | SEG_B | SEG_C,
+                                       SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G,
+                                       SEG_A | SEG_B | SEG_C | SEG_D | SEG_F | SEG_G };
+
+const byte FONT_ASCII[96] PROGMEM = {
+  0,                                                      // ' '
+  SEG_B | SEG_C,                                          // '!'
+  SEG_B | SEG_F,                                          // '"'
+  0,                                                      // '#'
+  SEG_A | SEG_C | SEG_D | SEG_F | SEG_G,                  // '$'
+  0,                                                      // '%'
+  0,                                                      // '&'
+  SEG_B,                                                  // '''
+  SEG_A | SEG_D | SEG_E | SEG_F,                          // '('
+  SEG_A | SEG_B | SEG_C | SEG_D,                          // ')'
+  SEG_A | SEG_B | SEG_F | SEG_G,                          // '*', degree sign
+  0,                                                      // '+'
+  0,                                                      // ','
+  SEG_G,                                                  // '-'
+  SEG_P,                                                  // '.'
+  SEG_B | SEG_E | SEG_G,                                  // '/'
+  SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F,          // '0'
+  SEG_B | SEG_C,                                          // '1'
+  SEG_A | SEG_B | SEG_D | SEG_E | SEG_G,                  // '2'
+  SEG_A | SEG_B | SEG_C | SEG_D | SEG_G,                  // '3'
+  SEG_B | SEG_C | SEG_F | SEG_G,                          // '4'
+  SEG_A | SEG_C | SEG_D | SEG_F | SEG_G,                  // '5'
+  SEG_A | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G,          // '6'
+  SEG_A | SEG_B | SEG_C,                                  // '7'
+  SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G,  // '8'
+  SEG_A | SEG_B | SEG_C | SEG_D | SEG_F | SEG_G,          // '9'
+  0,                                                      // ':'
+  0,                                                      // ';'
+  0,                                                      // '<'
+  SEG_D | SEG_G,                                          // '='
+  0,                                                      // '>'
+  SEG_A | SEG_B | SEG_E | SEG_G,                          // '?'
+  0,                                                      // '@'
+  SEG_A | SEG_B | SEG_C | SEG_E | SEG_F | SEG_G,          // 'A'
+  SEG_C | SEG_D | SEG_E | SEG_F | SEG_G,                  // 'B'
+  SEG_A | SEG_D | SEG_E | SEG_F,                          // 'C'
+  SEG_B | SEG_C | SEG_D | SEG_E | SEG_G,                  // 'D'
+  SEG_A | SEG_D | SEG_E | SEG_F | SEG_G,                  // 'E'
+  SEG_A | SEG_E | SEG_F | SEG_G,                          // 'F'
+  SEG_A | SEG_C | SEG_D | SEG_E | SEG_F,                  // 'G'
+  SEG_B | SEG_C | SEG_E | SEG_F | SEG_G,                  // 'H'
+  SEG_E | SEG_F,                                          // 'I'
+  SEG_B | SEG_C | SEG_D | SEG_E,                          // 'J'
+  SEG_A | SEG_C | SEG_E | SEG_F | SEG_G,                  // 'K'
+  SEG_D | SEG_E | SEG_F,                                  // 'L'
+  SEG_A | SEG_C | SEG_E,                                  // 'M'
+  SEG_C | SEG_E | SEG_G,                                  // 'N'
+  SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F,          // 'O'
+  SEG_A | SEG_B | SEG_E | SEG_F | SEG_G,                  // 'P'
+  SEG_A | SEG_B | SEG_C | SEG_F | SEG_G,                  // 'Q'
+  SEG_E | SEG_G,                                          // 'R'
+  SEG_A | SEG_C | SEG_D | SEG_F | SEG_G,                  // 'S'
+  SEG_D | SEG_E | SEG_F | SEG_G,                          // 'T'
+  SEG_B | SEG_C | SEG_D | SEG_E | SEG_F,                  // 'U'
+  SEG_C | SEG_D | SEG_E,                                  // 'V'
+  SEG_B | SEG_D | SEG_F,                                  // 'W'
+  SEG_B | SEG_C | SEG_E | SEG_F | SEG_G,                  // 'X'
+  SEG_B | SEG_C | SEG_D | SEG_F | SEG_G,                  // 'Y'
+  SEG_A | SEG_B | SEG_D | SEG_E | SEG_G,                  // 'Z'
+  SEG_A | SEG_D | SEG_E | SEG_F,                          // '['
+  SEG_C | SEG_F | SEG_G,                                  // '\'
+  SEG_A | SEG_B | SEG_C | SEG_D,                          // ']'
+  SEG_A | SEG_B | SEG_F,                                  // '^'
+  SEG_D,                                                  // '_'
+  SEG_F,                                                  // '`'
+  SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_G,          // 'a'
+  SEG_C | SEG_D | SEG_E | SEG_F | SEG_G,                  // 'b'
+  SEG_D | SEG_E | SEG_G,                                  // 'c'
+  SEG_B | SEG_C | SEG_D | SEG_E | SEG_G,                  // 'd'
+  SEG_A | SEG_B | SEG_D | SEG_E | SEG_F | SEG_G,          // 'e'
+  SEG_A | SEG_E | SEG_F | SEG_G,                          // 'f'
+  SEG_A | SEG_B | SEG_C | SEG_D | SEG_F | SEG_G,          // 'g'
+  SEG_C | SEG_E | SEG_F | SEG_G,                          // 'h'
+  SEG_C,                                                  // 'i'
+  SEG_B | SEG_C | SEG_D,                                  // 'j'
+  SEG_A | SEG_C | SEG_E | SEG_F | SEG_G,                  // 'k'
+  SEG_E | SEG_F,                                          // 'l'
+  SEG_A | SEG_C | SEG_E,                                  // 'm'
+  SEG_C | SEG_E | SEG_G,                                  // 'n'
+  SEG_C | SEG_D | SEG_E | SEG_G,                          // 'o'
+  SEG_A | SEG_B | SEG_E | SEG_F | SEG_G,                  // 'p'
+  SEG_A | SEG_B | SEG_C | SEG_F | SEG_G,                  // 'q'
+  SEG_E | SEG_G,                                          // 'r'
+  SEG_A | SEG_C | SEG_D | SEG_F | SEG_G,                  // 's'
+  SEG_D | SEG_E | SEG_F | SEG_G,                          // 't'
+  SEG_C | SEG_D | SEG_E,                                  // 'u'
+  SEG_C | SEG_D | SEG_E,                                  // 'v'
+  SEG_B | SEG_D | SEG_F,                                  // 'w'
+  SEG_B | SEG_C | SEG_E | SEG_F | SEG_G,                  // 'x'
+  SEG_B | SEG_C | SEG_D | SEG_F | SEG_G,                  // 'y'
+  SEG_A | SEG_B | SEG_D | SEG_E | SEG_G,                  // 'z'
+  0,                                                      // '{'
+  SEG_E | SEG_F,                                          // '|'
+  0,                                                      // '}'
+  SEG_A,                                                  // '~'
+  0                                                       // DEL
+};
+
+Font::Font(const byte digits[]) :
+      codes(digits), size(DIGITS_SIZE), first('0'), flash(false) {
+}
+
+Font::Font(const byte codes[], byte size, char first, boolean flash) :
+      codes(codes), size(size), first(first), flash(flash) {
+}
+
+Font Font::digits() {
+  return Font(FONT_DIGITS, sizeof(FONT_DIGITS), '0', true);
+}
+
+Font Font::ascii() {
+  return Font(FONT_ASCII, sizeof(FONT_ASCII), ' ', true);
+}
+
+byte Font::getCode(char c) const {
+  byte glyph = (byte) c - (byte) first;
+
+  if (glyph >= size) {
+    return 0;
+  }
+
+  return flash ? pgm_read_byte(codes + glyph) : codes[glyph];
+}
+
+} /* namespace DisplayGroup */
@@ -0,0 +1,91 @@
+/*
+ *  This file is part of DisplayGroup Library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ */
+
+
+#ifndef FONT_H_
+#define FONT_H_
+
+#include <Arduino.h>
+
+namespace DisplayGroup {
+
+extern const byte FONT_DIGITS[10] PROGMEM;    /**< The codes of DisplayManager::DEF_DIGITS, in flash */
+extern const byte FONT_ASCII[96] PROGMEM;     /**< Codes of the printable ASCII characters [' ', 127], in flash */
+
+/**
+ * @brief Table of 7-segments codes, one for each character, in RAM or in flash.
+ *
+ * A font maps the characters [first, first + size - 1] to 7-segments codes; the other
+ * characters are blank. The decimal digits are the characters '0' to '9', so a digits
+ * array [0-9] is a font whose first character is '0': it is converted implicitly,
+ * and it can be longer than 10 codes without harm.
+ * A font in flash (PROGMEM) costs no RAM: it is read with pgm_read_byte, once for
+ * each digit when a group is built, and once for each character when a text is rendered.
+ *
+ * The library fonts, FONT_DIGITS and FONT_ASCII, use the segments of
+ * DisplayManager::DEF_DIGITS. FONT_ASCII has the hexadecimal digits, a 7-segments
+ * approximation of the alphabet (upper and lower case), the blank (' '), the minus ('-'),
+ * the decimal point ('.') and the degree sign, on the character '*'.
+ */
+class Font {
+public:
+
+  static const byte DIGITS_SIZE = 10;   /**< Number of codes of a digits array [0-9] */
+
+  /**
+   * Font of the digits array [0-9] in RAM, e.g. DisplayManager::DEF_DIGITS.
+   *
+   * @param[in] digits[]    Array of 7-segments code for each digits [0-9]
+   */
+  Font(const byte digits[]);
+
+  /**
+   * Constructor.
+   *
+   * @param[in] codes[]     Array of 7-segments code for each character
+   * @param[in] size        Number of codes
+   * @param[in] first       Character of the first code
+   * @param[in] flash       True if the codes are in flash (PROGMEM), false if in RAM
+   */
+  Font(const byte codes[], byte size, char first, boolean flash);
+
+  /**
+   * @return The font of FONT_DIGITS, in flash
+   */
+  static Font digits();
+
+  /**
+   * @return The font of FONT_ASCII, in flash
+   */
+  static Font ascii();
+
+  /**
+   * @param[in] c           A character
+   * @return The 7-segments code of the character, most significant bit first, 0 (blank)
+   *         if it is not in the font
+   */
+  byte getCode(char c) const;
+
+  const byte * codes;     /**< Array of 7-segments code for each character */
+  byte size;              /**< Number of codes */
+  char first;             /**< Character of the first code */
+  boolean flash;          /**< True if the codes are in flash */
+};
+
+} /* namespace DisplayGroup */
+
+#endif /* FONT_H_ */
@@ -0,0 +1,312 @@
+/*
+ *  This file is part of DisplayGroup Library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ */
+
+#include "Arduino.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+static byte levels[HostHal::PIN_COUNT];
+static byte duties[HostHal::PIN_COUNT];
+static unsigned long transitions[HostHal::PIN_COUNT];
+static unsigned long writes = 0;
+static unsigned long allocatedBytes = 0;
+static unsigned long allocations = 0;
+static HostHal::PinListener listener = NULL;
+
+static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+void pinMode(uint8_t, uint8_t) {
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  assert(pin < HostHal::PIN_COUNT);
+
+  ++writes;
+  val = (val ? HIGH : LOW);
+  duties[pin] = (val ? 255 : 0);
+
+  if (levels[pin] != val) {
+    levels[pin] = val;
+    ++transitions[pin];
+
+    if (listener) {
+      listener(pin, val);
+    }
+  }
+}
+
+void analogWrite(uint8_t pin, int val) {
+  assert(pin < HostHal::PIN_COUNT);
+
+  // The level is high for any duty but 0, the duty is written after the level
+  digitalWrite(pin, val != 0);
+  duties[pin] = (byte) val;
+}
+
+int digitalRead(uint8_t pin) {
+  assert(pin < HostHal::PIN_COUNT);
+
+  return levels[pin];
+}
+
+unsigned long millis() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+unsigned long micros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+String::String() {
+}
+
+String::String(const char * str) :
+      std::string(str) {
+}
+
+String::String(const std::string & str) :
+      std::string(str) {
+}
+
+String::String(int value) :
+      std::string(std::to_string(value)) {
+}
+
+String::String(unsigned int value) :
+      std::string(std::to_string(value)) {
+}
+
+String::String(unsigned long value) :
+      std::string(std::to_string(value)) {
+}
+
+String & String::operator +=(const String & str) {
+  append(str);
+  return *this;
+}
+
+String & String::operator +=(const char * str) {
+  append(str);
+  return *this;
+}
+
+String operator +(const String & lhs, const String & rhs) {
+  String out(lhs);
+  return out += rhs;
+}
+
+String operator +(const String & lhs, const char * rhs) {
+  String out(lhs);
+  return out += rhs;
+}
+
+String operator +(const char * lhs, const String & rhs) {
+  String out(lhs);
+  return out += rhs;
+}
+
+String operator +(const String & lhs, unsigned char rhs) {
+  return lhs + String((unsigned int) rhs);
+}
+
+String operator +(const String & lhs, int rhs) {
+  return lhs + String(rhs);
+}
+
+#ifdef HOST_AVR
+void cli() {
+  HostHal::sreg &= ~0x80;
+}
+
+void sei() {
+  HostHal::sreg |= 0x80;
+}
+#endif
+
+void * operator new(size_t size) {
+  ++allocations;
+  allocatedBytes += size;
+
+  void * ptr = malloc(size ? size : 1);
+
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+
+  return ptr;
+}
+
+void operator delete(void * ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void * ptr, size_t) noexcept {
+  free(ptr);
+}
+
+namespace HostHal {
+
+#ifdef HOST_AVR
+volatile PortRegister ports[PIN_COUNT / 8];
+volatile uint8_t sreg = 0x80;
+volatile uint8_t spcr = 0;
+volatile uint8_t spsr = 0;
+volatile uint8_t tccr2a = 0;
+volatile uint8_t tccr2b = 0;
+volatile uint8_t tcnt2 = 0;
+volatile uint8_t ocr2a = 0;
+volatile uint8_t tifr2 = 0;
+volatile uint8_t timsk2 = 0;
+SpiDataRegister spdr;
+
+static byte spiBytes[256];
+static unsigned long spiWrites = 0;
+static PortListener portListener = NULL;
+
+void PortRegister::operator =(uint8_t value) volatile {
+  _value = value;
+
+  if (portListener) {
+    portListener((uint8_t) (this - ports + 1), value);
+  }
+}
+
+void PortRegister::operator |=(uint8_t mask) volatile {
+  *this = _value | mask;
+}
+
+void PortRegister::operator &=(uint8_t mask) volatile {
+  *this = _value & mask;
+}
+
+PortRegister::operator uint8_t() const volatile {
+  return _value;
+}
+
+SpiDataRegister & SpiDataRegister::operator =(uint8_t value) {
+  if (spiWrites < sizeof(spiBytes)) {
+    spiBytes[spiWrites] = value;
+  }
+
+  ++spiWrites;
+  spsr |= _BV(SPIF);
+  return *this;
+}
+
+SpiDataRegister::operator uint8_t() const {
+  spsr &= ~_BV(SPIF);
+  return 0;
+}
+
+unsigned long getSpiWrites() {
+  return spiWrites;
+}
+
+byte getSpiByte(unsigned long i) {
+  return i < sizeof(spiBytes) ? spiBytes[i] : 0;
+}
+
+void setPortListener(PortListener listener) {
+  portListener = listener;
+}
+#endif
+
+void resetCounters() {
+  for (byte i = 0; i < PIN_COUNT; ++i) {
+    transitions[i] = 0;
+  }
+
+  writes = 0;
+#ifdef HOST_AVR
+  spiWrites = 0;
+#endif
+  allocatedBytes = 0;
+  allocations = 0;
+}
+
+unsigned long getWrites() {
+  return writes;
+}
+
+unsigned long getTransitions() {
+  unsigned long count = 0;
+
+  for (byte i = 0; i < PIN_COUNT; ++i) {
+    count += transitions[i];
+  }
+
+  return count;
+}
+
+unsigned long getTransitions(uint8_t pin) {
+  assert(pin < PIN_COUNT);
+
+  return transitions[pin];
+}
+
+byte getLevel(uint8_t pin) {
+  assert(pin < PIN_COUNT);
+
+  return levels[pin];
+}
+
+byte getDuty(uint8_t pin) {
+  assert(pin < PIN_COUNT);
+
+  return duties[pin];
+}
+
+unsigned long getAllocatedBytes() {
+  return allocatedBytes;
+}
+
+unsigned long getAllocations() {
+  return allocations;
+}
+
+void setPinListener(PinListener pinListener) {
+  listener = pinListener;
+}
+
+static SequenceListener sequenceListener = NULL;
+static bool inSequenceListener = false;
+
+SequenceCount::SequenceCount(uint8_t value) :
+      _value(value) {
+}
+
+void SequenceCount::operator =(uint8_t value) volatile {
+  _value = value;
+}
+
+SequenceCount::operator uint8_t() const volatile {
+  if (sequenceListener && !inSequenceListener) {
+    inSequenceListener = true;
+    sequenceListener();
+    inSequenceListener = false;
+  }
+
+  return _value;
+}
+
+void setSequenceListener(SequenceListener listener) {
+  sequenceListener = listener;
+}
+
+} /* namespace HostHal */
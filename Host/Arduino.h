@@ -0,0 +1,293 @@
+/*
+ *  This file is part of DisplayGroup Library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ */
+
+#ifndef HOST_ARDUINO_H_
+#define HOST_ARDUINO_H_
+
+/*
+ * Host side simulation of the subset of the Arduino API used by the library.
+ * The pins are simulated in memory: every digitalWrite is counted, together with
+ * the level transitions of each pin, and the heap allocations are counted too.
+ * A PWM pin is simulated by its duty, see HostHal::getDuty.
+ * The port registers are simulated only when HOST_AVR is defined, see HostHal::ports:
+ * otherwise the library uses the digitalWrite path.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT  0x0
+#define OUTPUT 0x1
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+// The program memory is the data memory on the host
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *) (address))
+
+// The count of a Sequence is an object that reports every read, see
+// HostHal::setSequenceListener
+#define DISPLAYGROUP_SEQUENCE_COUNT volatile HostHal::SequenceCount
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+void analogWrite(uint8_t pin, int val);
+int digitalRead(uint8_t pin);
+
+unsigned long millis();
+unsigned long micros();
+
+#ifdef HOST_AVR
+// Simulated AVR port registers: pin n is the bit n % 8 of the port n / 8 + 1
+#define NOT_A_PIN 0
+#define digitalPinToPort(pin) ((uint8_t) ((pin) / 8 + 1))
+#define digitalPinToBitMask(pin) ((uint8_t) (1 << ((pin) % 8)))
+#define portOutputRegister(port) (HostHal::ports + (port) - 1)
+
+// The output registers are objects that report every write, see HostHal::setPortListener
+#define DISPLAYGROUP_PORT_REGISTER volatile HostHal::PortRegister
+
+#define SREG HostHal::sreg
+
+void cli();
+void sei();
+
+#define _BV(bit) (1 << (bit))
+
+// Simulated SPI peripheral: a byte written to SPDR is shifted out at once
+#define SPDR HostHal::spdr
+#define SPCR HostHal::spcr
+#define SPSR HostHal::spsr
+#define SPIE 7
+#define SPE 6
+#define MSTR 4
+#define SPIF 7
+#define SPI2X 0
+
+#define SS 10
+#define MOSI 11
+#define SCK 13
+
+// PWM pins of an Arduino Uno, digitalPinToTimer is defined by the cores of the AVR boards
+#define NOT_ON_TIMER 0
+#define TIMER0A 1
+#define TIMER0B 2
+#define TIMER1A 3
+#define TIMER1B 4
+#define TIMER2A 7
+#define TIMER2B 8
+#define digitalPinToTimer(pin) ((pin) == 3 ? TIMER2B : (pin) == 5 ? TIMER0B : (pin) == 6 ? TIMER0A \
+    : (pin) == 9 ? TIMER1A : (pin) == 10 ? TIMER1B : (pin) == 11 ? TIMER2A : NOT_ON_TIMER)
+
+// Simulated Timer2: the registers only hold the values written, the tests call the
+// compare match interrupt handler
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+#define TCCR2A HostHal::tccr2a
+#define TCCR2B HostHal::tccr2b
+#define TCNT2 HostHal::tcnt2
+#define OCR2A HostHal::ocr2a
+#define TIFR2 HostHal::tifr2
+#define TIMSK2 HostHal::timsk2
+#define WGM21 1
+#define OCF2A 1
+#define OCIE2A 1
+
+// An interrupt handler is a plain function, called by the tests in place of the hardware
+#define ISR(vector) extern "C" void vector()
+#endif
+
+/**
+ * @brief Minimal Arduino String, enough for DisplayManager::printGroups.
+ */
+class String: public std::string {
+public:
+  String();
+  String(const char * str);
+  String(const std::string & str);
+  explicit String(int value);
+  explicit String(unsigned int value);
+  explicit String(unsigned long value);
+
+  String & operator +=(const String & str);
+  String & operator +=(const char * str);
+};
+
+String operator +(const String & lhs, const String & rhs);
+String operator +(const String & lhs, const char * rhs);
+String operator +(const char * lhs, const String & rhs);
+String operator +(const String & lhs, unsigned char rhs);
+String operator +(const String & lhs, int rhs);
+
+namespace HostHal {
+
+static const byte PIN_COUNT = 64;       /**< Number of simulated pins */
+
+/**
+ * Reset the pin and allocation counters, the pin levels are kept.
+ */
+void resetCounters();
+
+/**
+ * @return The number of digitalWrite calls since the last reset
+ */
+unsigned long getWrites();
+
+/**
+ * @return The number of level transitions on all the pins since the last reset
+ */
+unsigned long getTransitions();
+
+/**
+ * @param[in] pin         The pin
+ * @return The number of level transitions on the pin since the last reset
+ */
+unsigned long getTransitions(uint8_t pin);
+
+/**
+ * @param[in] pin         The pin
+ * @return The current level of the pin
+ */
+byte getLevel(uint8_t pin);
+
+/**
+ * @param[in] pin         The pin
+ * @return The duty of the last analogWrite on the pin, 0 or 255 after a digitalWrite
+ */
+byte getDuty(uint8_t pin);
+
+/**
+ * @return The number of bytes allocated with operator new since the last reset
+ */
+unsigned long getAllocatedBytes();
+
+/**
+ * @return The number of calls to operator new since the last reset
+ */
+unsigned long getAllocations();
+
+/**
+ * Function called at every level transition of a pin, e.g. to decode the bits
+ * shifted out on the data and clock pins.
+ */
+typedef void (*PinListener)(uint8_t pin, uint8_t level);
+
+/**
+ * @param[in] listener    The function to call at each transition, NULL to disable
+ */
+void setPinListener(PinListener listener);
+
+/**
+ * @brief Count of a DisplayGroup::Sequence: every read is reported to the sequence listener.
+ */
+class SequenceCount {
+public:
+  SequenceCount(uint8_t value);
+  void operator =(uint8_t value) volatile;
+  operator uint8_t() const volatile;
+
+private:
+  uint8_t _value;
+};
+
+/**
+ * Function called at every read of the count of a sequence, but the reads made by the
+ * listener itself, e.g. to play an interrupt that writes a variable while a group reads it.
+ */
+typedef void (*SequenceListener)();
+
+/**
+ * @param[in] listener    The function to call at each read, NULL to disable
+ */
+void setSequenceListener(SequenceListener listener);
+
+#ifdef HOST_AVR
+/**
+ * @brief Output register of a port: every write is reported to the port listener.
+ */
+class PortRegister {
+public:
+  void operator =(uint8_t value) volatile;
+  void operator |=(uint8_t mask) volatile;
+  void operator &=(uint8_t mask) volatile;
+  operator uint8_t() const volatile;
+
+private:
+  uint8_t _value;
+};
+
+extern volatile PortRegister ports[PIN_COUNT / 8];  /**< Output register of each port, not seen by the pin counters */
+extern volatile uint8_t sreg;                   /**< Status register, bit 7 is the global interrupt enable */
+extern volatile uint8_t spcr;                   /**< SPI control register */
+extern volatile uint8_t spsr;                   /**< SPI status register */
+extern volatile uint8_t tccr2a;                 /**< Timer2 control register A */
+extern volatile uint8_t tccr2b;                 /**< Timer2 control register B, clock select */
+extern volatile uint8_t tcnt2;                  /**< Timer2 counter */
+extern volatile uint8_t ocr2a;                  /**< Timer2 output compare register A */
+extern volatile uint8_t tifr2;                  /**< Timer2 interrupt flag register */
+extern volatile uint8_t timsk2;                 /**< Timer2 interrupt mask register */
+
+/**
+ * @brief SPI data register: every byte written is recorded, and the transfer completes
+ * at once, setting SPIF.
+ */
+class SpiDataRegister {
+public:
+  SpiDataRegister & operator =(uint8_t value);
+  operator uint8_t() const;
+};
+
+extern SpiDataRegister spdr;                    /**< SPI data register */
+
+/**
+ * @return The number of bytes written to the SPI data register since the last reset
+ */
+unsigned long getSpiWrites();
+
+/**
+ * @param[in] i           A byte written to the SPI data register, from the last reset
+ * @return The byte, 0 after the first 256 bytes
+ */
+byte getSpiByte(unsigned long i);
+
+/**
+ * Function called at every write of an output register, e.g. to decode the bits shifted
+ * out on the data pins of a port at the rising edges of the clock.
+ */
+typedef void (*PortListener)(uint8_t port, uint8_t value);
+
+/**
+ * @param[in] listener    The function to call at each write, NULL to disable
+ */
+void setPortListener(PortListener listener);
+#endif
+
+} /* namespace HostHal */
+
+#endif /* HOST_ARDUINO_H_ */
@@ -0,0 +1,323 @@
+/*
+ *  This file is part of DisplayGroup Library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Host benchmark of the library, on the simulated pins of Host/Arduino.cpp.
+ *
+ * Every line of the output is a comma separated record:
+ *
+ *   benchmark,displays,groups,iterations,ns_per_op,toggles_per_op,bytes_per_op
+ *
+ * where displays is the length of the chain, groups the number of groups in the
+ * manager, ns_per_op the wall time of one operation, toggles_per_op the pin level
+ * transitions of one operation and bytes_per_op the bytes allocated with operator new
+ * by one operation. The first line is the header.
+ */
+
+#include <Arduino.h>
+
+#include <DisplayGroup.h>
+#include <DisplayManager.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using DisplayGroup::DisplayManager;
+using DisplayGroup::ShiftTransport;
+
+static const byte CHAINS[] = { 1, 4, 8, 16, 32, 64, 128, 255 };  /**< Chain lengths, in displays */
+static const byte GROUP_SIZE = 4;                               /**< Displays of each group, the last may be shorter */
+static const unsigned long OPERATIONS = 200000;                 /**< Displays updated by each benchmark, about */
+static const byte PIN_SEGMENT = 8;                              /**< Latch pin of segment 1, the next segments follow */
+
+/**
+ * @brief Measure of a benchmark: wall time and counters of the simulated HAL.
+ */
+class Measure {
+public:
+
+  Measure() {
+    HostHal::resetCounters();
+    _start = std::chrono::steady_clock::now();
+  }
+
+  /**
+   * Print the record of the benchmark.
+   */
+  void print(const char * name, unsigned int displays, unsigned int groups, unsigned long iterations) const {
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - _start).count();
+
+    printf("%s,%u,%u,%lu,%.1f,%.1f,%.1f\n", name, displays, groups, iterations, ns / iterations,
+        (double) HostHal::getTransitions() / iterations, (double) HostHal::getAllocatedBytes() / iterations);
+  }
+
+private:
+  std::chrono::steady_clock::time_point _start;
+};
+
+/**
+ * @return The number of groups in a chain of displays
+ */
+static unsigned int groupCount(unsigned int displays) {
+  return (displays + GROUP_SIZE - 1) / GROUP_SIZE;
+}
+
+/**
+ * @return The number of displays of the i-th group in a chain of displays
+ */
+static byte groupSize(unsigned int displays, unsigned int i) {
+  return (i + 1) * GROUP_SIZE <= displays ? GROUP_SIZE : displays - i * GROUP_SIZE;
+}
+
+/**
+ * Fill the manager with the groups of a chain of displays, each group watches a value.
+ */
+static void fill(DisplayManager & manager, unsigned int displays, std::vector<uint16_t> & values) {
+  values.assign(groupCount(displays), 0);
+
+  for (unsigned int i = 0; i < values.size(); ++i) {
+    manager.addGroup(i, groupSize(displays, i), &values[i]);
+  }
+}
+
+/**
+ * @return The number of iterations of a benchmark on a chain of displays
+ */
+static unsigned long iterations(unsigned int displays) {
+  return OPERATIONS / displays + 1;
+}
+
+/**
+ * DisplayManager::updateAll when all the watched values changed: render and shift the
+ * whole chain.
+ */
+static void benchUpdateAll(unsigned int displays) {
+  DisplayManager manager(PIN_COM_DATA, PIN_COM_CLOCK, PIN_OUTPUT_ENABLE, HIGH);
+  std::vector<uint16_t> values;
+  fill(manager, displays, values);
+  manager.updateAll();
+
+  unsigned long n = iterations(displays);
+  Measure measure;
+
+  for (unsigned long it = 0; it < n; ++it) {
+    for (unsigned int i = 0; i < values.size(); ++i) {
+      values[i] = (values[i] + 1) % 1000;
+    }
+
+    manager.updateAll();
+  }
+
+  measure.print("updateAll", displays, values.size(), n);
+}
+
+/**
+ * DisplayManager::updateAll when only the first group of the chain changed.
+ */
+static void benchUpdateOne(unsigned int displays) {
+  DisplayManager manager(PIN_COM_DATA, PIN_COM_CLOCK, PIN_OUTPUT_ENABLE, HIGH);
+  std::vector<uint16_t> values;
+  fill(manager, displays, values);
+  manager.updateAll();
+
+  unsigned long n = iterations(displays);
+  Measure measure;
+
+  for (unsigned long it = 0; it < n; ++it) {
+    values[0] = (values[0] + 1) % 10;
+    manager.updateAll();
+  }
+
+  measure.print("updateAll_one", displays, values.size(), n);
+}
+
+/**
+ * DisplayManager::updateAll when only the first group of the chain changed, with the chain
+ * split in segments of about the same length: only the segment of the first group is
+ * shifted out.
+ */
+static void benchUpdateSegment(unsigned int displays) {
+  DisplayManager manager(PIN_COM_DATA, PIN_COM_CLOCK, PIN_OUTPUT_ENABLE, HIGH);
+  std::vector<uint16_t> values;
+  fill(manager, displays, values);
+
+  unsigned int segments = values.size() < ShiftTransport::MAX_LANES ? values.size() : ShiftTransport::MAX_LANES;
+
+  for (unsigned int k = 1; k < segments; ++k) {
+    manager.setSegmentPin(k, PIN_SEGMENT + k - 1);
+  }
+
+  for (unsigned int i = 0; i < values.size(); ++i) {
+    manager.setChain(i, i * segments / values.size());
+  }
+
+  manager.updateAll();
+
+  unsigned long n = iterations(displays);
+  Measure measure;
+
+  for (unsigned long it = 0; it < n; ++it) {
+    values[0] = (values[0] + 1) % 10;
+    manager.updateAll();
+  }
+
+  measure.print("updateAll_segment", displays, values.size(), n);
+}
+
+/**
+ * DisplayManager::setValue of the first group of the chain, then DisplayManager::updateAll:
+ * the other groups watch their values.
+ */
+static void benchUpdatePush(unsigned int displays) {
+  DisplayManager manager(PIN_COM_DATA, PIN_COM_CLOCK, PIN_OUTPUT_ENABLE, HIGH);
+  std::vector<uint16_t> values;
+  fill(manager, displays, values);
+  manager.replaceGroup(0, groupSize(displays, 0), DisplayGroup::Value::UINT16);
+  manager.updateAll();
+
+  unsigned long n = iterations(displays);
+  Measure measure;
+
+  for (unsigned long it = 0; it < n; ++it) {
+    manager.setValue(0, it % 10);
+    manager.updateAll();
+  }
+
+  measure.print("setValue", displays, values.size(), n);
+}
+
+/**
+ * DisplayManager::updateAll when nothing changed.
+ */
+static void benchUpdateIdle(unsigned int displays) {
+  DisplayManager manager(PIN_COM_DATA, PIN_COM_CLOCK, PIN_OUTPUT_ENABLE, HIGH);
+  std::vector<uint16_t> values;
+  fill(manager, displays, values);
+  manager.updateAll();
+
+  unsigned long n = iterations(displays);
+  Measure measure;
+
+  for (unsigned long it = 0; it < n; ++it) {
+    manager.updateAll();
+  }
+
+  measure.print("updateAll_idle", displays, values.size(), n);
+}
+
+/**
+ * DisplayGroup::render of a single group as wide as the chain, up to 255 displays.
+ */
+static void benchGroupRender(unsigned int displays) {
+  uint16_t value = 0;
+  DisplayGroup::DisplayGroup group(displays, 0, &value, DisplayManager::DEF_DIGITS);
+  std::vector<byte> frame(displays);
+
+  unsigned long n = iterations(displays);
+  Measure measure;
+
+  for (unsigned long it = 0; it < n; ++it) {
+    value = (value + 7) % 10000;
+    group.render(&frame[0]);
+  }
+
+  measure.print("DisplayGroup::render", displays, 1, n);
+}
+
+/**
+ * DisplayManager::addGroup of all the groups of a chain, then DisplayManager::clearGroups.
+ * One operation is one addGroup.
+ */
+static void benchAddGroup(unsigned int displays) {
+  DisplayManager manager(PIN_COM_DATA, PIN_COM_CLOCK, PIN_OUTPUT_ENABLE, HIGH);
+  std::vector<uint16_t> values(groupCount(displays));
+
+  unsigned long n = iterations(displays);
+  Measure measure;
+
+  for (unsigned long it = 0; it < n; ++it) {
+    for (unsigned int i = 0; i < values.size(); ++i) {
+      manager.addGroup(i, groupSize(displays, i), &values[i]);
+    }
+
+    manager.clearGroups();
+  }
+
+  measure.print("addGroup", displays, values.size(), n * values.size());
+}
+
+/**
+ * DisplayManager::insertGroup of all the groups of a chain, each one at the head of the
+ * manager, then DisplayManager::clearGroups. One operation is one insertGroup.
+ */
+static void benchInsertGroup(unsigned int displays) {
+  DisplayManager manager(PIN_COM_DATA, PIN_COM_CLOCK, PIN_OUTPUT_ENABLE, HIGH);
+  std::vector<uint16_t> values(groupCount(displays));
+
+  unsigned long n = iterations(displays);
+  Measure measure;
+
+  for (unsigned long it = 0; it < n; ++it) {
+    for (unsigned int i = 0; i < values.size(); ++i) {
+      manager.insertGroup(i, groupSize(displays, i), 0, &values[i]);
+    }
+
+    manager.clearGroups();
+  }
+
+  measure.print("insertGroup", displays, values.size(), n * values.size());
+}
+
+/**
+ * DisplayManager::removeGroup of the last group of a full chain, then DisplayManager::addGroup
+ * to put it back. One operation is one removeGroup and one addGroup.
+ */
+static void benchRemoveGroup(unsigned int displays) {
+  DisplayManager manager(PIN_COM_DATA, PIN_COM_CLOCK, PIN_OUTPUT_ENABLE, HIGH);
+  std::vector<uint16_t> values;
+  fill(manager, displays, values);
+
+  byte last = values.size() - 1;
+  unsigned long n = iterations(displays) * values.size();
+  Measure measure;
+
+  for (unsigned long it = 0; it < n; ++it) {
+    manager.removeGroup(last);
+    manager.addGroup(last, groupSize(displays, last), &values[last]);
+  }
+
+  measure.print("removeGroup", displays, values.size(), n);
+}
+
+int main() {
+  printf("benchmark,displays,groups,iterations,ns_per_op,toggles_per_op,bytes_per_op\n");
+
+  for (unsigned int i = 0; i < sizeof(CHAINS); ++i) {
+    benchUpdateAll(CHAINS[i]);
+    benchUpdateOne(CHAINS[i]);
+    benchUpdateSegment(CHAINS[i]);
+    benchUpdatePush(CHAINS[i]);
+    benchUpdateIdle(CHAINS[i]);
+    benchGroupRender(CHAINS[i]);
+    benchAddGroup(CHAINS[i]);
+    benchInsertGroup(CHAINS[i]);
+    benchRemoveGroup(CHAINS[i]);
+  }
+
+  return 0;
+}
@@ -0,0 +1,1737 @@
+/*
+ *  This file is part of DisplayGroup Library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Host tests of the library, on the simulated pins of Host/Arduino.cpp.
+ *
+ * Built twice by make test: with the digitalWrite path of the host, and with HOST_AVR,
+ * which simulates the AVR registers used by the library so that its AVR only paths are
+ * compiled and run. Every failed check prints its line, the exit status is the number
+ * of failures.
+ */
+
+#include <Arduino.h>
+
+#include <Bcd.h>
+#include <DisplayGroup.h>
+#include <DisplayManager.h>
+#include <StaticDisplayManager.h>
+
+#include <cstdio>
+
+using DisplayGroup::Animation;
+using DisplayGroup::AnimationStep;
+using DisplayGroup::Animator;
+using DisplayGroup::Bcd;
+using DisplayGroup::BitBangTransport;
+using DisplayGroup::DisplayManager;
+using DisplayGroup::Value;
+
+static const byte PIN_DATA = 2;         /**< Data pin of the chain */
+static const byte PIN_CLOCK = 4;        /**< Clock pin of the chain */
+static const byte PIN_LATCH = 3;        /**< Output enable (or latch) pin of the chain */
+
+static unsigned int failures = 0;       /**< Number of failed checks */
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+/**
+ * Count and print a failed check.
+ */
+static void check(bool condition, const char * text, int line) {
+  if (!condition) {
+    printf("Test.cpp:%d: check failed: %s\n", line, text);
+    ++failures;
+  }
+}
+
+/**
+ * @param[in] frame       The displays of a group, the rightmost first
+ * @param[in] size        Number of displays
+ * @param[in] text        What the displays read, the leftmost first: digits, '-', ' ' for
+ *                        a blank display, and '.' for the point of the previous display
+ * @return True if the frame holds the default codes of the text
+ */
+static bool reads(const byte frame[], byte size, const char * text) {
+  byte expected[16];
+  byte i = size;
+
+  for (; *text != '\0'; ++text) {
+    if (*text == '.') {
+      if (i == size) {
+        return false;
+      }
+
+      expected[i] |= DisplayManager::DEF_POINT;
+      continue;
+    }
+
+    if (i == 0) {
+      return false;
+    }
+
+    --i;
+
+    if (*text == ' ') {
+      expected[i] = 0;
+    } else if (*text == '-') {
+      expected[i] = DisplayManager::DEF_MINUS;
+    } else {
+      expected[i] = DisplayManager::DEF_DIGITS[*text - '0'];
+    }
+  }
+
+  if (i != 0) {
+    return false;
+  }
+
+  for (i = 0; i < size; ++i) {
+    if (frame[i] != expected[i]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+#ifndef HOST_AVR
+
+/**
+ * @brief Bytes seen on the data pin at the rising edges of the clock pin.
+ */
+class Wire {
+public:
+
+  static const unsigned int SIZE = 64;  /**< Maximum number of bytes recorded */
+
+  /**
+   * Start recording, through the pin listener of the HAL.
+   */
+  static void record() {
+    _bits = 0;
+    HostHal::setPinListener(&Wire::onPin);
+  }
+
+  /**
+   * Stop recording.
+   */
+  static void stop() {
+    HostHal::setPinListener(NULL);
+  }
+
+  /**
+   * @return The number of whole bytes recorded
+   */
+  static unsigned int size() {
+    return _bits / 8;
+  }
+
+  /**
+   * @param[in] i           A byte, in the order it was shifted out
+   * @return The byte, the first bit shifted out as the most significant
+   */
+  static byte at(unsigned int i) {
+    return _bytes[i];
+  }
+
+private:
+
+  static void onPin(uint8_t pin, uint8_t level) {
+    if (pin == PIN_CLOCK && level == HIGH && _bits < 8 * SIZE) {
+      byte & out = _bytes[_bits / 8];
+
+      out = (byte) (out << 1 | HostHal::getLevel(PIN_DATA));
+      ++_bits;
+    }
+  }
+
+  static byte _bytes[SIZE];
+  static unsigned int _bits;
+};
+
+byte Wire::_bytes[Wire::SIZE];
+unsigned int Wire::_bits = 0;
+
+/**
+ * Without port registers the software transport shifts with digitalWrite, most
+ * significant bit first.
+ */
+static void testBitBangPins() {
+  BitBangTransport transport(PIN_DATA, PIN_CLOCK);
+
+  transport.begin();
+  HostHal::resetCounters();
+
+  Wire::record();
+  transport.write(0xA5);
+  transport.write(0x01);
+  Wire::stop();
+
+  CHECK(HostHal::getWrites() == 2 * 8 * 3);
+  CHECK(Wire::size() == 2);
+  CHECK(Wire::at(0) == 0xA5);
+  CHECK(Wire::at(1) == 0x01);
+}
+
+/**
+ * The bit order of a group is honoured on the wire: the codes of the digits most
+ * significant bit first, or bit reversed for LSBFIRST, the rightmost display first.
+ */
+static void testBitOrderWire() {
+  DisplayManager manager(PIN_DATA, PIN_CLOCK, PIN_LATCH, HIGH);
+  uint16_t value = 42;
+
+  manager.addGroup(0, 2, &value);
+
+  Wire::record();
+  manager.updateAll();
+  Wire::stop();
+
+  CHECK(Wire::size() == 2);
+  CHECK(Wire::at(0) == DisplayManager::DEF_DIGITS[2]);
+  CHECK(Wire::at(1) == DisplayManager::DEF_DIGITS[4]);
+
+  manager.setBitOrder(0, LSBFIRST);
+
+  Wire::record();
+  manager.updateAll();
+  Wire::stop();
+
+  CHECK(Wire::size() == 2);
+  CHECK(Wire::at(0) == DisplayManager::reverseBits(DisplayManager::DEF_DIGITS[2]));
+  CHECK(Wire::at(1) == DisplayManager::reverseBits(DisplayManager::DEF_DIGITS[4]));
+}
+
+/**
+ * Without DISPLAYGROUP_ASYNC a static manager has no output buffer: a commit shifts the
+ * frame before returning.
+ */
+static void testStaticCommit() {
+  DisplayGroup::StaticDisplayManager<2, 4> manager(PIN_DATA, PIN_CLOCK, PIN_LATCH, HIGH);
+  uint16_t value = 42;
+
+  CHECK(manager.addGroup(0, 2, &value));
+  CHECK(manager.addGroup(1, 2, &value));
+  CHECK(!manager.addGroup(2, 1, &value));
+
+  Wire::record();
+  manager.commit();
+  Wire::stop();
+
+  CHECK(!manager.isBusy());
+  CHECK(Wire::size() == 4);
+
+  for (byte i = 0; i < 4; ++i) {
+    CHECK(Wire::at(i) == manager.getFrame()[i]);
+  }
+}
+
+/**
+ * Two managers on different pins drive only their own pins, and a manager on a user
+ * supplied transport does not touch the default pins of the software transport.
+ */
+static void testManagerPins() {
+  static const byte OTHER_DATA = 5;
+  static const byte OTHER_CLOCK = 6;
+  static const byte OTHER_LATCH = 7;
+
+  DisplayManager first(PIN_DATA, PIN_CLOCK, PIN_LATCH, HIGH);
+  DisplayManager second(OTHER_DATA, OTHER_CLOCK, OTHER_LATCH, HIGH);
+  BitBangTransport transport(8, 9);
+  DisplayManager third(transport, 10, HIGH);
+
+  first.addGroup(0, 2, Value(Value::UINT16));
+  second.addGroup(0, 2, Value(Value::UINT16));
+  third.addGroup(0, 2, Value(Value::UINT16));
+  first.setValue(0, 55);
+  second.setValue(0, 55);
+  third.setValue(0, 55);
+
+  HostHal::resetCounters();
+  second.updateAll();
+
+  CHECK(HostHal::getTransitions(OTHER_DATA) != 0);
+  CHECK(HostHal::getTransitions(OTHER_CLOCK) != 0);
+  CHECK(HostHal::getTransitions(OTHER_LATCH) != 0);
+
+  bool own = true;
+
+  for (byte pin = 0; pin < HostHal::PIN_COUNT; ++pin) {
+    own = own && (HostHal::getTransitions(pin) == 0 || pin == OTHER_DATA || pin == OTHER_CLOCK
+        || pin == OTHER_LATCH);
+  }
+
+  CHECK(own);
+
+  HostHal::resetCounters();
+  third.updateAll();
+
+  for (byte pin = 0; pin < HostHal::PIN_COUNT; ++pin) {
+    own = own && (HostHal::getTransitions(pin) == 0 || pin == 8 || pin == 9 || pin == 10);
+  }
+
+  CHECK(own);
+  CHECK(HostHal::getTransitions(8) != 0 && HostHal::getTransitions(9) != 0);
+
+  HostHal::resetCounters();
+  first.updateAll();
+
+  for (byte pin = 0; pin < HostHal::PIN_COUNT; ++pin) {
+    own = own && (HostHal::getTransitions(pin) == 0 || pin == PIN_DATA || pin == PIN_CLOCK
+        || pin == PIN_LATCH);
+  }
+
+  CHECK(own);
+  CHECK(HostHal::getTransitions(PIN_DATA) != 0 && HostHal::getTransitions(PIN_CLOCK) != 0);
+}
+
+/**
+ * Inside a batch the updates touch no pin; the changes are shifted out once, when the
+ * outermost batch is committed.
+ */
+static void testBatch() {
+  DisplayManager manager(PIN_DATA, PIN_CLOCK, PIN_LATCH, HIGH);
+  uint16_t value = 12;
+
+  manager.addGroup(0, 2, &value);
+  manager.addGroup(1, 2, Value(Value::UINT8));
+  manager.updateAll();
+
+  manager.beginBatch();
+  manager.beginBatch();
+  HostHal::resetCounters();
+
+  value = 34;
+  manager.setValue(1, 56);
+  manager.updateAll();
+  manager.forceUpdate();
+  manager.commit();
+  CHECK(HostHal::getWrites() == 0);
+
+  // The inner batch does not shift out
+  manager.commitBatch();
+  CHECK(HostHal::getWrites() == 0);
+
+  byte latches = manager.getLatchCount();
+
+  Wire::record();
+  manager.commitBatch();
+  Wire::stop();
+
+  CHECK(Wire::size() == 4);
+  CHECK(manager.getLatchCount() == (byte) (latches + 1));
+  CHECK(reads(manager.getFrame(), 4, "3456"));
+
+  // Nothing left to shift out
+  HostHal::resetCounters();
+  manager.updateAll();
+  CHECK(HostHal::getWrites() == 0);
+}
+
+/**
+ * A pushed value is rendered in the frame by setValue, and the next update only shifts
+ * it out. Pushing the value shown does nothing.
+ */
+static void testSetValue() {
+  DisplayManager manager(PIN_DATA, PIN_CLOCK, PIN_LATCH, HIGH);
+
+  manager.addGroup(0, 3, Value(Value::UINT16));
+  manager.addGroup(1, 2, Value(Value::UINT8));
+  manager.updateAll();
+  CHECK(!manager.isPending());
+
+  manager.setValue(1, 42);
+  CHECK(manager.isPending());
+  CHECK(reads(manager.getFrame(), 5, "00042"));
+
+  Wire::record();
+  manager.updateAll();
+  Wire::stop();
+
+  CHECK(!manager.isPending());
+  CHECK(Wire::size() == 5);
+
+  for (byte i = 0; i < 5; ++i) {
+    CHECK(Wire::at(i) == manager.getFrame()[i]);
+  }
+
+  // The value shown: nothing rendered, nothing shifted
+  manager.setValue(1, 42);
+  CHECK(!manager.isPending());
+
+  Wire::record();
+  manager.updateAll();
+  Wire::stop();
+  CHECK(Wire::size() == 0);
+}
+
+/**
+ * After a change of the groups, or a failed render of the group, setValue leaves the
+ * frame alone and the next update renders the whole frame.
+ */
+static void testSetValueFallback() {
+  DisplayManager manager(PIN_DATA, PIN_CLOCK, PIN_LATCH, HIGH);
+
+  manager.addGroup(0, 2, Value(Value::UINT16));
+  manager.addGroup(1, 2, Value(Value::UINT16));
+  manager.updateAll();
+
+  // Replaced by a group of the same size: the frame is not moved, but the layout changed
+  manager.replaceGroup(1, 2, Value(Value::UINT16));
+  manager.setValue(0, 12);
+  CHECK(reads(manager.getFrame(), 4, "0000"));
+
+  manager.updateAll();
+  CHECK(reads(manager.getFrame(), 4, "1200"));
+
+  // The first push that does not fit is rendered in place, with its failure
+  manager.setValue(1, 345);
+  CHECK(reads(manager.getFrame(), 4, "1245"));
+  manager.updateAll();
+
+  // The group failed: the next push waits for the update
+  manager.setValue(1, 67);
+  CHECK(reads(manager.getFrame(), 4, "1245"));
+  CHECK(!manager.isPending());
+
+  manager.updateAll();
+  CHECK(reads(manager.getFrame(), 4, "1267"));
+}
+
+/**
+ * An animated group keeps the codes of its animation when the whole frame is rendered
+ * again, e.g. by DisplayManager::forceUpdate: the value is not shown under it.
+ */
+static void testAnimationForceUpdate() {
+  static const byte CODES[] = { 0x11, 0x22 };
+
+  DisplayManager manager(PIN_DATA, PIN_CLOCK, PIN_LATCH, HIGH);
+  Animation animation(CODES, sizeof(CODES));
+  uint16_t value = 42;
+
+  manager.addGroup(0, 2, &value);
+  manager.updateAll();
+  manager.showCodes(0, animation, 0);
+
+  Wire::record();
+  manager.forceUpdate();
+  Wire::stop();
+
+  // The leftmost display is shifted last
+  CHECK(Wire::size() == 2);
+  CHECK(Wire::at(0) == 0x22);
+  CHECK(Wire::at(1) == 0x11);
+
+  // A new value is not shown while the group is animated
+  value = 7;
+  Wire::record();
+  manager.updateAll();
+  Wire::stop();
+  CHECK(Wire::size() == 0);
+
+  manager.showValue(0);
+  manager.updateAll();
+  CHECK(manager.getFrame()[0] != 0x22);
+}
+
+/**
+ * A disabled animated group is blank, and its animation is back when it is enabled.
+ */
+static void testAnimationDisabled() {
+  static const byte CODES[] = { 0x11, 0x22 };
+
+  DisplayManager manager(PIN_DATA, PIN_CLOCK, PIN_LATCH, HIGH);
+  Animation animation(CODES, sizeof(CODES));
+  uint16_t value = 42;
+
+  manager.addGroup(0, 2, &value);
+  manager.showCodes(0, animation, 0);
+  manager.updateAll();
+
+  manager.enableGroup(0, false);
+
+  Wire::record();
+  manager.updateAll();
+  Wire::stop();
+
+  CHECK(Wire::size() == 2);
+  CHECK(Wire::at(0) == 0 && Wire::at(1) == 0);
+
+  manager.enableGroup(0, true);
+
+  Wire::record();
+  manager.updateAll();
+  Wire::stop();
+
+  CHECK(Wire::size() == 2);
+  CHECK(Wire::at(0) == 0x22 && Wire::at(1) == 0x11);
+}
+
+/**
+ * Showing again the frame on the displays marks nothing to shift.
+ */
+static void testShowCodesUnchanged() {
+  static const byte CODES[] = { 0x11, 0x22, 0x33, 0x44 };
+
+  DisplayManager manager(PIN_DATA, PIN_CLOCK, PIN_LATCH, HIGH);
+  Animation animation(CODES, sizeof(CODES));
+  uint16_t value = 42;
+
+  manager.addGroup(0, 2, &value);
+  manager.showCodes(0, animation, 1);
+  manager.updateAll();
+  CHECK(!manager.isPending());
+
+  manager.showCodes(0, animation, 1);
+  CHECK(!manager.isPending());
+
+  Wire::record();
+  manager.updateAll();
+  Wire::stop();
+  CHECK(Wire::size() == 0);
+
+  manager.showCodes(0, animation, 0);
+  CHECK(manager.isPending());
+  CHECK(manager.getFrame()[0] == 0x22 && manager.getFrame()[1] == 0x11);
+}
+
+/**
+ * The frames of the three modes: frames of the group width, a strip scrolled once from
+ * the right, and a strip turning without end.
+ */
+static void testAnimationModes() {
+  static const byte CODES[] = { 0x01, 0x02, 0x03, 0x04 };
+
+  Animation frames(CODES, 4, Animation::FRAMES);
+  CHECK(frames.getFrameCount(2) == 2);
+  CHECK(frames.getCode(1, 0, 2) == 0x03 && frames.getCode(1, 1, 2) == 0x04);
+  CHECK(frames.getFrameCount(0) == 0);
+
+  // The strip enters on the right and leaves on the left: 3 codes in 2 displays
+  Animation scroll(CODES, 3, Animation::SCROLL);
+  static const byte SCROLLED[5][2] = { { 0, 0x01 }, { 0x01, 0x02 }, { 0x02, 0x03 }, { 0x03, 0 }, { 0, 0 } };
+
+  CHECK(scroll.getFrameCount(2) == 5);
+
+  for (byte f = 0; f < 5; ++f) {
+    CHECK(scroll.getCode(f, 0, 2) == SCROLLED[f][0]);
+    CHECK(scroll.getCode(f, 1, 2) == SCROLLED[f][1]);
+  }
+
+  // The last code is followed by the first one
+  Animation marquee(CODES, 3, Animation::MARQUEE);
+
+  CHECK(marquee.getFrameCount(2) == 3);
+  CHECK(marquee.getCode(2, 0, 2) == 0x03 && marquee.getCode(2, 1, 2) == 0x01);
+  CHECK(marquee.getCode(1, 0, 2) == 0x02 && marquee.getCode(1, 1, 2) == 0x03);
+
+  // Wider than the strip: the codes wrap more than once
+  CHECK(marquee.getCode(0, 4, 5) == 0x02);
+}
+
+/**
+ * The sequencer plays each step for its frames, ticks and repeat count, and stops at the
+ * end of the sequence with the group back to its value and the fade at full brightness.
+ */
+static void testAnimator() {
+  static const byte PIN_DIMMING = 6;
+  static const AnimationStep STEPS[] = {
+    { Animator::HOLD, NULL, 1, 2 },
+    { Animator::BLINK, NULL, 2, 1 },
+    { Animator::FADE_IN, NULL, 1, 1 }
+  };
+
+  DisplayManager manager(PIN_DATA, PIN_CLOCK, PIN_LATCH, HIGH);
+  Animator animator(manager, 0);
+  uint16_t value = 42;
+
+  manager.addGroup(0, 2, &value);
+  CHECK(manager.setDimmingPin(PIN_DIMMING));
+  manager.setBrightness(0);
+  manager.updateAll();
+
+  CHECK(!animator.tick());
+  animator.play(STEPS, 3);
+  CHECK(animator.isPlaying());
+
+  // Hold twice, one tick each
+  for (byte i = 0; i < 2; ++i) {
+    CHECK(animator.tick());
+    manager.updateAll();
+    CHECK(manager.getFrame()[0] == DisplayManager::DEF_DIGITS[2]);
+  }
+
+  // Blink: blank for two ticks, then the value for two ticks
+  for (byte i = 0; i < 4; ++i) {
+    CHECK(animator.tick());
+    manager.updateAll();
+    CHECK(manager.getFrame()[0] == (i < 2 ? 0 : DisplayManager::DEF_DIGITS[2]));
+  }
+
+  // Fade in: one level at each tick
+  CHECK(animator.tick());
+  CHECK(manager.getBrightness() == 255 / Animator::FADE_LEVELS);
+  CHECK(HostHal::getDuty(PIN_DIMMING) == 255 - 255 / Animator::FADE_LEVELS);
+
+  for (byte i = 1; i < Animator::FADE_LEVELS; ++i) {
+    CHECK(animator.tick());
+  }
+
+  CHECK(manager.getBrightness() == 255);
+
+  CHECK(!animator.tick());
+  CHECK(!animator.isPlaying());
+}
+
+#else
+
+#ifdef DISPLAYGROUP_ASYNC
+// Defined by the library: the link fails if the interrupt handler is not compiled
+extern "C" void SPI_STC_vect();
+#endif
+
+#ifdef DISPLAYGROUP_MULTIPLEX
+extern "C" void TIMER2_COMPA_vect();
+#endif
+
+/**
+ * With port registers the software transport writes the registers only: the feature
+ * test of the library must see the port macros of the core.
+ */
+static void testBitBangPorts() {
+#ifndef DISPLAYGROUP_PORT_IO
+  CHECK(!"DISPLAYGROUP_PORT_IO not defined with the port macros of the core");
+#endif
+
+  BitBangTransport transport(PIN_DATA, PIN_CLOCK);
+  DisplayGroup::PortRegister & port = *portOutputRegister(digitalPinToPort(PIN_DATA));
+  byte dataMask = digitalPinToBitMask(PIN_DATA);
+  byte clockMask = digitalPinToBitMask(PIN_CLOCK);
+
+  transport.begin();
+  HostHal::resetCounters();
+
+  // The data pin keeps the last bit, the clock pin ends high
+  transport.write(0x81);
+  CHECK((port & (dataMask | clockMask)) == (dataMask | clockMask));
+
+  transport.write(0x80);
+  CHECK((port & (dataMask | clockMask)) == clockMask);
+
+  CHECK(HostHal::getWrites() == 0);
+  CHECK(HostHal::sreg & 0x80);
+}
+
+/**
+ * @brief Bytes seen on the data pins of a port at the rising edges of the clock pin, one
+ * stream for each lane of a ParallelTransport.
+ */
+class PortWire {
+public:
+
+  static const unsigned int SIZE = 16;  /**< Maximum number of bytes recorded on each lane */
+  static const byte LANES = 4;          /**< Number of lanes recorded */
+
+  /**
+   * Start recording, through the port listener of the HAL.
+   *
+   * @param[in] dataPins    Data pin of each lane, all on one port
+   * @param[in] keep        Bits of the data port that must not change
+   */
+  static void record(const byte dataPins[], byte keep) {
+    for (byte k = 0; k < LANES; ++k) {
+      _masks[k] = digitalPinToBitMask(dataPins[k]);
+    }
+
+    _dataPort = digitalPinToPort(dataPins[0]);
+    _keep = keep;
+    _kept = *portOutputRegister(_dataPort) & keep;
+    _preserved = true;
+    _bits = 0;
+    HostHal::setPortListener(&PortWire::onWrite);
+  }
+
+  /**
+   * Stop recording.
+   */
+  static void stop() {
+    HostHal::setPortListener(NULL);
+  }
+
+  /**
+   * @return The number of whole bytes recorded on each lane
+   */
+  static unsigned int size() {
+    return _bits / 8;
+  }
+
+  /**
+   * @param[in] lane        The lane
+   * @param[in] i           A byte, in the order it was shifted out
+   * @return The byte, the first bit shifted out as the most significant
+   */
+  static byte at(byte lane, unsigned int i) {
+    return _bytes[lane][i];
+  }
+
+  /**
+   * @return True if no write changed the bits of the data port to keep
+   */
+  static bool preserved() {
+    return _preserved;
+  }
+
+private:
+
+  static void onWrite(uint8_t port, uint8_t value) {
+    static const byte CLOCK_MASK = digitalPinToBitMask(PIN_CLOCK);
+
+    if (port == _dataPort) {
+      _preserved = _preserved && (value & _keep) == _kept;
+    }
+
+    // The clock pin is low between two bits, a write that leaves it high is the edge
+    if (port == digitalPinToPort(PIN_CLOCK) && (value & CLOCK_MASK) != 0 && !_clock && _bits < 8 * SIZE) {
+      byte data = *portOutputRegister(_dataPort);
+
+      for (byte k = 0; k < LANES; ++k) {
+        byte & out = _bytes[k][_bits / 8];
+
+        out = (byte) (out << 1 | ((data & _masks[k]) != 0));
+      }
+
+      ++_bits;
+    }
+
+    if (port == digitalPinToPort(PIN_CLOCK)) {
+      _clock = (value & CLOCK_MASK) != 0;
+    }
+  }
+
+  static byte _masks[LANES];
+  static byte _dataPort;
+  static byte _keep;
+  static byte _kept;
+  static bool _preserved;
+  static bool _clock;
+  static unsigned int _bits;
+  static byte _bytes[LANES][SIZE];
+};
+
+byte PortWire::_masks[PortWire::LANES];
+byte PortWire::_dataPort = 0;
+byte PortWire::_keep = 0;
+byte PortWire::_kept = 0;
+bool PortWire::_preserved = true;
+bool PortWire::_clock = false;
+unsigned int PortWire::_bits = 0;
+byte PortWire::_bytes[PortWire::LANES][PortWire::SIZE];
+
+/**
+ * The lanes of a ParallelTransport are shifted out through one port, each lane on the bit
+ * of its own pin, most significant bit first; the other pins of the port do not change.
+ * The manager pads the shorter chains at the head, so that their bytes reach the far end.
+ */
+static void testParallelPorts() {
+  // Data pins on the same port, not in the order of their bits
+  static const byte DATA_PINS[PortWire::LANES] = { 20, 17, 22, 19 };
+  static const byte KEEP = 0x81;        // Pins 16 and 23, not data pins
+
+  DisplayGroup::ParallelTransport transport(DATA_PINS, 3, PIN_CLOCK);
+  DisplayGroup::PortRegister & port = *portOutputRegister(digitalPinToPort(DATA_PINS[0]));
+
+  transport.begin();
+  port = KEEP;
+
+  const byte values[] = { 0xA5, 0x3C, 0x81 };
+
+  HostHal::resetCounters();
+  PortWire::record(DATA_PINS, KEEP);
+  transport.writeLanes(values);
+  PortWire::stop();
+
+  CHECK(PortWire::size() == 1);
+  CHECK(PortWire::at(0, 0) == 0xA5 && PortWire::at(1, 0) == 0x3C && PortWire::at(2, 0) == 0x81);
+  CHECK(PortWire::at(3, 0) == 0);
+  CHECK(PortWire::preserved());
+  CHECK((port & KEEP) == KEEP);
+  CHECK(HostHal::getWrites() == 0);
+  CHECK(HostHal::sreg & 0x80);
+
+  // Chains of 2, 1 and 3 displays on three lanes, the fourth lane without a chain
+  DisplayGroup::ParallelTransport lanes(DATA_PINS, 4, PIN_CLOCK);
+  DisplayManager manager(lanes, PIN_LATCH, HIGH);
+
+  manager.addGroup(0, 2, Value(Value::UINT16));
+  manager.addGroup(1, 1, Value(Value::UINT16));
+  manager.addGroup(2, 3, Value(Value::UINT16));
+  manager.setChain(1, 1);
+  manager.setChain(2, 2);
+  manager.setValue(0, 12);
+  manager.setValue(1, 3);
+  manager.setValue(2, 456);
+
+  port = KEEP;
+  PortWire::record(DATA_PINS, KEEP);
+  manager.updateAll();
+  PortWire::stop();
+
+  const byte * frame = manager.getFrame();
+  static const byte START[] = { 0, 2, 3 };
+  static const byte SIZE[] = { 2, 1, 3 };
+
+  CHECK(PortWire::size() == 3);
+
+  for (byte k = 0; k < 3; ++k) {
+    byte pad = 3 - SIZE[k];
+
+    for (byte i = 0; i < 3; ++i) {
+      CHECK(PortWire::at(k, i) == (i < pad ? 0 : frame[START[k] + i - pad]));
+    }
+  }
+
+  CHECK(PortWire::at(3, 0) == 0 && PortWire::at(3, 1) == 0 && PortWire::at(3, 2) == 0);
+  CHECK(reads(frame, 2, "12") && reads(frame + 2, 1, "3") && reads(frame + 3, 3, "456"));
+  CHECK(PortWire::preserved());
+
+  // The other tests start from a cleared port
+  port = 0;
+}
+
+/**
+ * The SPI transport is declared and implemented with the SPI registers of the core, and
+ * a manager shifts its frame through the SPI data register.
+ */
+static void testSpi() {
+#ifdef DISPLAYGROUP_SPI
+  DisplayGroup::SpiTransport spi;
+  DisplayManager manager(spi, PIN_LATCH, HIGH);
+  uint16_t value = 42;
+
+  manager.addGroup(0, 3, &value);
+  HostHal::resetCounters();
+
+  CHECK(manager.updateAll() == 0);
+  CHECK(HostHal::getSpiWrites() == 3);
+
+  // The frame buffer is in the order of the shift
+  for (byte i = 0; i < 3; ++i) {
+    CHECK(HostHal::getSpiByte(i) == manager.getFrame()[i]);
+  }
+
+  CHECK((SPCR & (_BV(SPE) | _BV(MSTR))) == (_BV(SPE) | _BV(MSTR)));
+#else
+  CHECK(!"DISPLAYGROUP_SPI not defined with the SPI registers of the core");
+#endif
+}
+
+/**
+ * A committed frame is shifted out in background by the SPI transfer complete interrupt,
+ * one byte at each interrupt, and latched by the last one.
+ */
+static void testSpiAsync() {
+#ifdef DISPLAYGROUP_ASYNC
+  DisplayGroup::SpiTransport spi;
+  DisplayManager manager(spi, PIN_LATCH, HIGH);
+  uint16_t value = 123;
+
+  manager.addGroup(0, 4, &value);
+  manager.updateAll();
+
+  value = 456;
+  HostHal::resetCounters();
+
+  byte latches = manager.getLatchCount();
+  manager.commit();
+
+  // The first byte is written by the commit, the others by the interrupt
+  CHECK(manager.isBusy());
+  CHECK(spi.isBusy());
+  CHECK(HostHal::getSpiWrites() == 1);
+
+  unsigned int interrupts = 0;
+
+  while (spi.isBusy() && interrupts < 100) {
+    SPI_STC_vect();
+    ++interrupts;
+  }
+
+  CHECK(interrupts == 4);
+  CHECK(!manager.isBusy());
+  CHECK((byte) (manager.getLatchCount() - latches) == 1);
+  CHECK(HostHal::getSpiWrites() == 4);
+
+  for (byte i = 0; i < 4; ++i) {
+    CHECK(HostHal::getSpiByte(i) == manager.getFrame()[i]);
+  }
+#else
+  CHECK(!"DISPLAYGROUP_ASYNC not kept with the SPI transport");
+#endif
+}
+
+
+/**
+ * A commit while a frame is shifted out in background does not render: a new layout
+ * would move the segments under the interrupt, which keeps shifting the old frame.
+ */
+static void testCommitWhileBusy() {
+#ifdef DISPLAYGROUP_ASYNC
+  static const byte PIN_SEGMENT = 5;
+
+  DisplayGroup::SpiTransport spi;
+  DisplayManager manager(spi, PIN_LATCH, HIGH);
+  uint16_t first = 12, second = 34, third = 567;
+
+  manager.addGroup(0, 2, &first);
+  manager.addGroup(1, 2, &second);
+  CHECK(manager.setSegmentPin(1, PIN_SEGMENT));
+  manager.setChain(1, 1);
+  manager.updateAll();
+
+  first = 21;
+  second = 43;
+  HostHal::resetCounters();
+  manager.commit();
+  CHECK(manager.isBusy());
+
+  byte shifted[4];
+
+  for (byte i = 0; i < 4; ++i) {
+    shifted[i] = manager.getFrame()[i];
+  }
+
+  // A new group on the first segment, while the second one is still to be shifted
+  manager.addGroup(2, 3, &third);
+  manager.commit();
+  CHECK(manager.getFrameSize() == 4);
+
+  unsigned int interrupts = 0;
+
+  while (manager.isBusy() && interrupts < 100) {
+    SPI_STC_vect();
+    ++interrupts;
+  }
+
+  CHECK(!manager.isBusy());
+  CHECK(HostHal::getSpiWrites() == 4);
+
+  for (byte i = 0; i < 4; ++i) {
+    CHECK(HostHal::getSpiByte(i) == shifted[i]);
+  }
+
+  // The new layout is rendered and sent by the next commit
+  manager.commit();
+
+  while (manager.isBusy() && interrupts < 200) {
+    SPI_STC_vect();
+    ++interrupts;
+  }
+
+  CHECK(manager.getFrameSize() == 7);
+  CHECK(HostHal::getSpiWrites() == 4 + 7);
+#else
+  CHECK(!"DISPLAYGROUP_ASYNC not kept with the SPI transport");
+#endif
+}
+
+/**
+ * The Timer2 compare match interrupt refreshes the multiplexed displays: the timer is
+ * configured by startTimer, each interrupt shows the next display, and stopTimer turns
+ * the displays off.
+ */
+static void testMultiplexTimer() {
+#ifdef DISPLAYGROUP_MULTIPLEX
+  static const byte DIGIT_PINS[] = { 16, 17, 18 };
+
+  DisplayGroup::SpiTransport spi;
+  DisplayGroup::MultiplexTransport mux(spi, PIN_LATCH, DIGIT_PINS, 3, HIGH);
+  DisplayGroup::PortRegister & digits = *portOutputRegister(digitalPinToPort(DIGIT_PINS[0]));
+
+  mux.begin();
+  mux.write(0x11);
+  mux.write(0x22);
+  mux.write(0x33);
+  mux.flush();
+
+  // 300 interrupts per second: 16 MHz / 256 / 208
+  CHECK(DisplayGroup::MultiplexTransport::startTimer(mux, 100));
+  CHECK(TCCR2A == _BV(WGM21));
+  CHECK(TCCR2B == 6);
+  CHECK(OCR2A == 207);
+  CHECK(TIMSK2 == _BV(OCIE2A));
+
+  HostHal::resetCounters();
+
+  static const byte CODES[] = { 0x22, 0x33, 0x11 };
+
+  for (byte i = 0; i < 3; ++i) {
+    TIMER2_COMPA_vect();
+
+    CHECK(HostHal::getSpiWrites() == (unsigned long) i + 1);
+    CHECK(HostHal::getSpiByte(i) == CODES[i]);
+    CHECK(digits == digitalPinToBitMask(DIGIT_PINS[(i + 1) % 3]));
+  }
+
+  DisplayGroup::MultiplexTransport::stopTimer();
+  CHECK(TIMSK2 == 0);
+  CHECK(TCCR2B == 0);
+  CHECK(digits == 0);
+
+  // Stopped: the interrupt no longer refreshes
+  TIMER2_COMPA_vect();
+  CHECK(HostHal::getSpiWrites() == 3);
+#else
+  CHECK(!"DISPLAYGROUP_MULTIPLEX not kept with the Timer2 registers of the core");
+#endif
+}
+
+#endif
+
+/**
+ * @return True if the digits and their count are those found by division
+ */
+static bool isDecimal(uint32_t value, const byte digits[], byte size, byte count) {
+  byte significant = 1;
+
+  for (byte i = 0; i < size; ++i, value /= 10) {
+    if (digits[i] != value % 10) {
+      return false;
+    }
+
+    if (value != 0) {
+      significant = i + 1;
+    }
+  }
+
+  return value == 0 && count == significant;
+}
+
+/**
+ * The division-free conversions give the digits of a division by 10: all the 8 and 16
+ * bits values, and the edges of every power of ten plus a sweep for 32 bits.
+ */
+static void testBcd() {
+  byte digits[Bcd::MAX_DIGITS_32];
+  unsigned int errors = 0;
+
+  for (unsigned int value = 0; value <= 0xFF; ++value) {
+    byte count = Bcd::convert((uint8_t) value, digits);
+    errors += !isDecimal(value, digits, Bcd::MAX_DIGITS_8, count);
+  }
+
+  CHECK(errors == 0);
+  errors = 0;
+
+  for (unsigned long value = 0; value <= 0xFFFF; ++value) {
+    byte count = Bcd::convert((uint16_t) value, digits);
+    errors += !isDecimal(value, digits, Bcd::MAX_DIGITS_16, count);
+  }
+
+  CHECK(errors == 0);
+  errors = 0;
+
+  static const uint32_t EDGES[] = { 0, 1, 0x7FFFFFFFUL, 0x80000000UL, 4000000000UL,
+      4294967294UL, 4294967295UL };
+
+  for (byte i = 0; i < sizeof(EDGES) / sizeof(EDGES[0]); ++i) {
+    byte count = Bcd::convert(EDGES[i], digits);
+    errors += !isDecimal(EDGES[i], digits, Bcd::MAX_DIGITS_32, count);
+  }
+
+  // 10^k - 1, 10^k and 10^k + 1 for every power of ten
+  for (uint32_t power = 10; power != 0; power = (power <= 0xFFFFFFFFUL / 10 ? power * 10 : 0)) {
+    for (uint32_t value = power - 1; value != power + 2; ++value) {
+      byte count = Bcd::convert(value, digits);
+      errors += !isDecimal(value, digits, Bcd::MAX_DIGITS_32, count);
+    }
+  }
+
+  // Pseudo-random values over the whole range
+  uint32_t value = 1;
+
+  for (unsigned long i = 0; i < 100000; ++i) {
+    value = value * 1664525UL + 1013904223UL;
+
+    byte count = Bcd::convert(value, digits);
+    errors += !isDecimal(value, digits, Bcd::MAX_DIGITS_32, count);
+  }
+
+  CHECK(errors == 0);
+}
+
+/**
+ * The digit codes are bit reversed once by setBitOrder: LSBFIRST renders the reversed
+ * codes of the font, and MSBFIRST restores them, a flash font included.
+ */
+static void testBitOrderTable() {
+  uint16_t value = 1234;
+  DisplayGroup::DisplayGroup group(4, 0, Value(&value), DisplayGroup::Font(DisplayGroup::FONT_DIGITS, 10, '0', true));
+  byte frame[4];
+
+  group.setBitOrder(LSBFIRST);
+  group.render(frame);
+
+  for (byte i = 0; i < 4; ++i) {
+    CHECK(frame[i] == DisplayManager::reverseBits(DisplayManager::DEF_DIGITS[4 - i]));
+  }
+
+  group.setBitOrder(LSBFIRST);
+  group.render(frame);
+  CHECK(frame[0] == DisplayManager::reverseBits(DisplayManager::DEF_DIGITS[4]));
+
+  group.setBitOrder(MSBFIRST);
+  group.render(frame);
+
+  for (byte i = 0; i < 4; ++i) {
+    CHECK(frame[i] == DisplayManager::DEF_DIGITS[4 - i]);
+  }
+}
+
+/**
+ * Each type of value is rendered from the watched variable of its width, zero padded, with
+ * the minus on the most significant display, and -3 when it does not fit.
+ */
+static void testValueTypes() {
+  const DisplayGroup::Font digits(DisplayManager::DEF_DIGITS);
+  byte frame[11];
+
+  int8_t int8 = -5;
+  DisplayGroup::DisplayGroup int8Group(3, 0, Value(&int8), digits);
+  CHECK(int8Group.render(frame) == 0);
+  CHECK(reads(frame, 3, "-05"));
+
+  int8 = -128;
+  CHECK(int8Group.render(frame) == -3);
+  CHECK(reads(frame, 3, "-28"));
+
+  uint8_t uint8 = 255;
+  DisplayGroup::DisplayGroup uint8Group(3, 0, Value(&uint8), digits);
+  CHECK(uint8Group.render(frame) == 0);
+  CHECK(reads(frame, 3, "255"));
+
+  int16_t int16 = -1234;
+  DisplayGroup::DisplayGroup int16Group(5, 0, Value(&int16), digits);
+  CHECK(int16Group.render(frame) == 0);
+  CHECK(reads(frame, 5, "-1234"));
+
+  int32_t int32 = -2147483647L - 1;
+  DisplayGroup::DisplayGroup int32Group(11, 0, Value(&int32), digits);
+  CHECK(int32Group.render(frame) == 0);
+  CHECK(reads(frame, 11, "-2147483648"));
+
+  DisplayGroup::DisplayGroup int32Short(10, 0, Value(&int32), digits);
+  CHECK(int32Short.render(frame) == -3);
+  CHECK(reads(frame, 10, "-147483648"));
+
+  uint32_t uint32 = 4294967295UL;
+  DisplayGroup::DisplayGroup uint32Group(10, 0, Value(&uint32), digits);
+  CHECK(uint32Group.render(frame) == 0);
+  CHECK(reads(frame, 10, "4294967295"));
+
+  DisplayGroup::DisplayGroup uint32Short(9, 0, Value(&uint32), digits);
+  CHECK(uint32Short.render(frame) == -3);
+  CHECK(reads(frame, 9, "294967295"));
+
+  // A pushed value, sign extended from its type
+  DisplayGroup::DisplayGroup pushed(4, 0, Value(Value::INT8), digits);
+  pushed.setValue(0xFF);
+  CHECK(pushed.render(frame) == 0);
+  CHECK(reads(frame, 4, "-001"));
+
+  // The 32 bits conversion against the C library, over the whole range
+  char text[16];
+  uint32_t value = 1;
+  bool same = true;
+
+  for (unsigned int i = 0; i < 10000; ++i) {
+    value = value * 1664525UL + 1013904223UL;
+    int32 = (int32_t) value;
+    int32Group.render(frame);
+
+    if (int32 < 0) {
+      sprintf(text, "-%010lu", (unsigned long) (0 - value));
+    } else {
+      sprintf(text, "%011lu", (unsigned long) value);
+    }
+
+    same = same && reads(frame, 11, text);
+  }
+
+  CHECK(same);
+}
+
+/**
+ * A fixed point value lights the point of the units and pads with zeros up to them.
+ */
+static void testFixedPoint() {
+  const DisplayGroup::Font digits(DisplayManager::DEF_DIGITS);
+  byte frame[8];
+
+  int16_t int16 = -5;
+  DisplayGroup::DisplayGroup int16Group(5, 0, Value(&int16, 2), digits);
+  CHECK(int16Group.render(frame) == 0);
+  CHECK(reads(frame, 5, "-00.05"));
+
+  int16 = 12345;
+  CHECK(int16Group.render(frame) == 0);
+  CHECK(reads(frame, 5, "123.45"));
+
+  uint32_t uint32 = 123456;
+  DisplayGroup::DisplayGroup uint32Group(8, 0, Value(&uint32, 3), digits);
+  CHECK(uint32Group.render(frame) == 0);
+  CHECK(reads(frame, 8, "00123.456"));
+
+  // The units do not fit: no point and -3
+  uint8_t uint8 = 5;
+  DisplayGroup::DisplayGroup uint8Group(3, 0, Value(&uint8, 3), digits);
+  CHECK(uint8Group.render(frame) == -3);
+  CHECK(reads(frame, 3, "005"));
+}
+
+/**
+ * The minus and point set by setSymbols are reversed with the digits by setBitOrder, and
+ * restored by the opposite order.
+ */
+static void testSymbolsBitOrder() {
+  int16_t value = -12;
+  DisplayGroup::DisplayGroup group(4, 0, Value(&value, 1), DisplayGroup::Font(DisplayManager::DEF_DIGITS));
+  const byte minus = 0x02;
+  const byte point = 0x01;
+  byte frame[4];
+
+  group.setSymbols(minus, point);
+  group.render(frame);
+  CHECK(frame[3] == minus);
+  CHECK(frame[1] == (DisplayManager::DEF_DIGITS[1] | point));
+
+  group.setBitOrder(LSBFIRST);
+  group.render(frame);
+  CHECK(frame[3] == DisplayManager::reverseBits(minus));
+  CHECK(frame[1] == DisplayManager::reverseBits(DisplayManager::DEF_DIGITS[1] | point));
+  CHECK(frame[0] == DisplayManager::reverseBits(DisplayManager::DEF_DIGITS[2]));
+
+  group.setBitOrder(MSBFIRST);
+  group.render(frame);
+  CHECK(frame[3] == minus);
+  CHECK(frame[1] == (DisplayManager::DEF_DIGITS[1] | point));
+}
+
+/**
+ * A group renders only when its value changed, from a single snapshot of the value.
+ */
+static void testRenderChanged() {
+  uint16_t value = 42;
+  DisplayGroup::DisplayGroup group(2, 0, Value(&value), DisplayGroup::Font(DisplayManager::DEF_DIGITS));
+  byte frame[2] = { 0, 0 };
+
+  CHECK(group.renderChanged(frame));
+  CHECK(frame[0] == DisplayManager::DEF_DIGITS[2]);
+  CHECK(!group.renderChanged(frame));
+
+  value = 57;
+  CHECK(group.isChanged());
+  CHECK(group.renderChanged(frame));
+  CHECK(frame[0] == DisplayManager::DEF_DIGITS[7]);
+  CHECK(frame[1] == DisplayManager::DEF_DIGITS[5]);
+  CHECK(!group.isChanged());
+
+  group.setEnabled(false);
+  CHECK(group.renderChanged(frame));
+  CHECK(frame[0] == 0 && frame[1] == 0);
+
+  value = 12;
+  CHECK(!group.renderChanged(frame));
+}
+
+/**
+ * A counter counts on its decimal digits with a ripple carry, and writes only the
+ * digits changed by the carry in a frame already rendered.
+ */
+static void testCounter() {
+  DisplayGroup::DisplayGroup group(3, 0, Value(Value::COUNTER), DisplayGroup::Font(DisplayManager::DEF_DIGITS));
+  byte frame[3];
+
+  group.setValue(98);
+  group.render(frame);
+  CHECK(reads(frame, 3, "098"));
+
+  // Two digits carried at once
+  CHECK(group.count(true, frame));
+  CHECK(group.count(true, frame));
+  CHECK(reads(frame, 3, "100"));
+  CHECK(group.getCount() == 100);
+
+  // Only the units change: the other displays are not written
+  frame[1] = frame[2] = 0xEE;
+  CHECK(group.count(true, frame));
+  CHECK(frame[0] == DisplayManager::DEF_DIGITS[1] && frame[1] == 0xEE && frame[2] == 0xEE);
+
+  // The carry writes the tens, and the hundreds are still not written
+  group.setValue(109);
+  group.render(frame);
+  frame[2] = 0xEE;
+  CHECK(group.count(true, frame));
+  CHECK(frame[0] == DisplayManager::DEF_DIGITS[0] && frame[1] == DisplayManager::DEF_DIGITS[1]);
+  CHECK(frame[2] == 0xEE);
+
+  // The borrow ripples down as well
+  group.setValue(100);
+  group.render(frame);
+  CHECK(group.count(false, frame));
+  CHECK(reads(frame, 3, "099"));
+  CHECK(group.getCount() == 99);
+  CHECK(group.getResult() == 0);
+}
+
+/**
+ * Past the digits of the displays a counter overflows to more digits (-3), wraps around
+ * or saturates, at both ends.
+ */
+static void testCounterModes() {
+  DisplayGroup::DisplayGroup group(2, 0, Value(Value::COUNTER), DisplayGroup::Font(DisplayManager::DEF_DIGITS));
+  byte frame[2];
+
+  // Overflow: 8 digits, as a watched value, the displays cannot show the count
+  group.setValue(99);
+  group.render(frame);
+  CHECK(group.count(true, frame));
+  CHECK(group.getCount() == 100);
+  CHECK(group.getResult() == -3);
+
+  group.setValue(0);
+  group.render(frame);
+  CHECK(group.getResult() == 0);
+  CHECK(group.count(false, frame));
+  CHECK(group.getCount() == 99999999UL);
+  CHECK(group.getResult() == -3);
+
+  // Wrap: on the digits of the displays
+  group.setCounterMode(DisplayGroup::DisplayGroup::COUNTER_WRAP);
+  group.setValue(99);
+  group.render(frame);
+  CHECK(group.count(true, frame));
+  CHECK(group.getCount() == 0);
+  CHECK(reads(frame, 2, "00"));
+  CHECK(group.getResult() == 0);
+
+  CHECK(group.count(false, frame));
+  CHECK(group.getCount() == 99);
+  CHECK(reads(frame, 2, "99"));
+  CHECK(group.getResult() == 0);
+
+  // Saturate: the count stops at all nines and at 0
+  group.setCounterMode(DisplayGroup::DisplayGroup::COUNTER_SATURATE);
+  CHECK(!group.count(true, frame));
+  CHECK(group.getCount() == 99);
+
+  group.setValue(0);
+  group.render(frame);
+  CHECK(!group.count(false, frame));
+  CHECK(group.getCount() == 0);
+  CHECK(group.count(true, frame));
+  CHECK(reads(frame, 2, "01"));
+}
+
+/**
+ * @param[out] text       What a clock of 4 displays reads, see reads
+ * @param[in]  tenths     The time, in tenths of second
+ */
+static void clockText(char * text, uint32_t tenths) {
+  unsigned long seconds = tenths / 10;
+
+  if (seconds >= 60) {
+    sprintf(text, "%02lu.%02lu", seconds / 60, seconds % 60);
+  } else {
+    sprintf(text, " %02lu.%lu", seconds, (unsigned long) (tenths % 10));
+  }
+}
+
+/**
+ * A clock follows the time tick by tick up to DisplayGroup::CLOCK_STEPS ticks and converts
+ * longer changes at once, with the same digits, both ways across the minute.
+ */
+static void testClockSteps() {
+  DisplayGroup::DisplayGroup group(4, 0, Value(Value::CLOCK, 1), DisplayGroup::Font(DisplayManager::DEF_DIGITS));
+  byte frame[4];
+  char text[8];
+  uint32_t time = 0;
+  bool same = true;
+
+  // One tick at a time, up to 12 minutes and back
+  for (; time <= 7200; ++time) {
+    group.setValue(time);
+    group.render(frame);
+    clockText(text, time);
+    same = same && reads(frame, 4, text);
+  }
+
+  for (time = 7200; time-- != 0;) {
+    group.setValue(time);
+    group.render(frame);
+    clockText(text, time);
+    same = same && reads(frame, 4, text);
+  }
+
+  CHECK(same);
+
+  // The longest change made by steps, then the shortest jump, both ways
+  const uint32_t changes[] = { DisplayGroup::DisplayGroup::CLOCK_STEPS, DisplayGroup::DisplayGroup::CLOCK_STEPS + 1, 173 };
+
+  for (byte i = 0; i < 3; ++i) {
+    for (time = 0; time <= 7200; time += changes[i]) {
+      group.setValue(time);
+      group.render(frame);
+      clockText(text, time);
+      same = same && reads(frame, 4, text);
+    }
+
+    for (time -= changes[i]; time >= changes[i]; time -= changes[i]) {
+      group.setValue(time - changes[i]);
+      group.render(frame);
+      clockText(text, time - changes[i]);
+      same = same && reads(frame, 4, text);
+    }
+  }
+
+  CHECK(same);
+}
+
+/**
+ * A clock reads ss.t with the point of the seconds below one minute, mm:ss with the colon
+ * on the point of the minutes from one minute, stops at 99:59.9, and takes its time in
+ * seconds, tenths, hundredths or milliseconds.
+ */
+static void testClockFormat() {
+  DisplayGroup::DisplayGroup tenths(4, 0, Value(Value::CLOCK, 1), DisplayGroup::Font(DisplayManager::DEF_DIGITS));
+  byte frame[4];
+
+  tenths.setValue(599);
+  tenths.render(frame);
+  CHECK(reads(frame, 4, " 59.9"));
+  CHECK((frame[1] & DisplayManager::DEF_POINT) != 0 && (frame[2] & DisplayManager::DEF_POINT) == 0);
+
+  // The switch at one minute moves the point to the colon
+  CHECK(tenths.setValue(600));
+  tenths.render(frame);
+  CHECK(reads(frame, 4, "01.00"));
+  CHECK((frame[1] & DisplayManager::DEF_POINT) == 0 && (frame[2] & DisplayManager::DEF_POINT) != 0);
+
+  // The tenths are not shown from one minute, but they are counted
+  CHECK(tenths.setValue(609));
+  tenths.render(frame);
+  CHECK(reads(frame, 4, "01.00"));
+  CHECK(tenths.setValue(610));
+  tenths.render(frame);
+  CHECK(reads(frame, 4, "01.01"));
+
+  // The clock stops at 99:59.9, by steps and by a jump
+  tenths.setValue(59990);
+  tenths.setValue(59999);
+  tenths.render(frame);
+  CHECK(reads(frame, 4, "99.59"));
+  CHECK(!tenths.setValue(60000));
+  CHECK(!tenths.setValue(1000000UL));
+  tenths.render(frame);
+  CHECK(reads(frame, 4, "99.59"));
+  CHECK(tenths.getResult() == 0);
+
+  // Seconds: always mm:ss
+  DisplayGroup::DisplayGroup seconds(4, 0, Value(Value::CLOCK), DisplayGroup::Font(DisplayManager::DEF_DIGITS));
+
+  seconds.setValue(59);
+  seconds.render(frame);
+  CHECK(reads(frame, 4, "00.59"));
+  seconds.setValue(60);
+  seconds.render(frame);
+  CHECK(reads(frame, 4, "01.00"));
+  seconds.setValue(5999);
+  seconds.render(frame);
+  CHECK(reads(frame, 4, "99.59"));
+
+  // Hundredths: a change within a tenth does not change the digits
+  DisplayGroup::DisplayGroup hundredths(4, 0, Value(Value::CLOCK, 2), DisplayGroup::Font(DisplayManager::DEF_DIGITS));
+
+  hundredths.setValue(1234);
+  hundredths.render(frame);
+  CHECK(reads(frame, 4, " 12.3"));
+  CHECK(!hundredths.setValue(1239));
+  CHECK(hundredths.setValue(1240));
+  hundredths.render(frame);
+  CHECK(reads(frame, 4, " 12.4"));
+
+  // Milliseconds
+  DisplayGroup::DisplayGroup millis(4, 0, Value(Value::CLOCK, 3), DisplayGroup::Font(DisplayManager::DEF_DIGITS));
+
+  millis.setValue(59999);
+  millis.render(frame);
+  CHECK(reads(frame, 4, " 59.9"));
+  CHECK(millis.setValue(61500));
+  millis.render(frame);
+  CHECK(reads(frame, 4, "01.01"));
+
+  // Three displays do not fit the tens of the minutes
+  DisplayGroup::DisplayGroup small(3, 0, Value(Value::CLOCK), DisplayGroup::Font(DisplayManager::DEF_DIGITS));
+
+  small.setValue(599);
+  CHECK(small.render(frame) == 0);
+  CHECK(reads(frame, 3, "9.59"));
+  small.setValue(600);
+  CHECK(small.render(frame) == -3);
+}
+
+/**
+ * The groups are found by their id after inserts at the front and in the middle, after
+ * the removal of a middle group, which moves the group of the last slot to its slot, and
+ * after a replace.
+ */
+static void testGroupIds() {
+  DisplayManager manager(PIN_DATA, PIN_CLOCK, PIN_LATCH, HIGH);
+
+  CHECK(manager.addGroup(1, 1, Value(Value::UINT8)));
+  CHECK(manager.addGroup(2, 1, Value(Value::UINT8)));
+  CHECK(manager.insertGroup(3, 1, 0, Value(Value::UINT8)));
+  CHECK(manager.insertGroup(4, 1, 1, Value(Value::UINT8)));
+  CHECK(!manager.addGroup(4, 1, Value(Value::UINT8)));
+
+  for (byte id = 1; id <= 4; ++id) {
+    manager.setValue(id, id);
+  }
+
+  manager.updateAll();
+  CHECK(reads(manager.getFrame(), 4, "3412"));
+
+  // Group 4, in the last slot, moves to the slot of group 1
+  manager.removeGroup(1);
+  CHECK(manager.getGroupCount() == 3);
+  CHECK(manager.getDisplayNumber(1) == 0);
+  manager.setValue(1, 5);
+  manager.setValue(4, 9);
+  manager.updateAll();
+  CHECK(reads(manager.getFrame(), 3, "392"));
+
+  CHECK(manager.replaceGroup(2, 2, Value(Value::UINT8)));
+  CHECK(!manager.replaceGroup(1, 2, Value(Value::UINT8)));
+  CHECK(manager.getDisplayNumber(2) == 2);
+  manager.setValue(2, 42);
+  manager.setValue(3, 7);
+  manager.updateAll();
+  CHECK(reads(manager.getFrame(), 4, "7942"));
+
+  // A removed id can be added again, at the end
+  CHECK(manager.addGroup(1, 1, Value(Value::UINT8)));
+  manager.setValue(1, 1);
+  manager.updateAll();
+  CHECK(reads(manager.getFrame(), 5, "79421"));
+}
+
+/**
+ * A manager holds at most 254 groups, the slot 0xFF being DisplayManager::NO_GROUP, and
+ * every id, 255 included, is found.
+ */
+static void testGroupLimit() {
+  DisplayManager manager(PIN_DATA, PIN_CLOCK, PIN_LATCH, HIGH);
+  bool added = true;
+
+  for (unsigned int id = 0; id < 254; ++id) {
+    added = added && manager.addGroup(id, 1, Value(Value::UINT8));
+  }
+
+  CHECK(added);
+  CHECK(manager.getGroupCount() == 254);
+  CHECK(!manager.addGroup(254, 1, Value(Value::UINT8)));
+  CHECK(!manager.addGroup(255, 1, Value(Value::UINT8)));
+  CHECK(manager.getDisplayNumber(254) == 0);
+  CHECK(manager.getDisplayNumber(255) == 0);
+
+  manager.removeGroup(0);
+  CHECK(manager.addGroup(255, 2, Value(Value::UINT8)));
+  CHECK(manager.getDisplayNumber(255) == 2);
+
+  bool found = true;
+
+  for (unsigned int id = 1; id < 254; ++id) {
+    found = found && manager.getDisplayNumber(id) == 1;
+  }
+
+  CHECK(found);
+  CHECK(manager.getDisplayNumber(0) == 0);
+}
+
+static DisplayGroup::Sequence * playedSequence = NULL;   /**< Sequence bumped by the played interrupt */
+static volatile uint16_t * playedVariable = NULL;        /**< Variable written by the played interrupt */
+static uint16_t playedValue = 0;                         /**< Value written by the played interrupt */
+static unsigned int playedAt = 0;                        /**< Read of the count that plays it, 0 for none */
+static unsigned int sequenceReads = 0;                   /**< Reads of the count of a sequence */
+
+/**
+ * Sequence listener: an interrupt that writes the variable and bumps its sequence, just
+ * after the read of the count given by playedAt.
+ */
+static void playInterrupt() {
+  if (++sequenceReads == playedAt) {
+    *playedVariable = playedValue;
+    playedSequence->bump();
+  }
+}
+
+/**
+ * A group reads its variable again when the Sequence moved during the read, and a group
+ * without a Sequence reads it once.
+ */
+static void testSequence() {
+  DisplayGroup::Sequence sequence;
+  DisplayManager manager(PIN_DATA, PIN_CLOCK, PIN_LATCH, HIGH);
+
+  // The group read 0x13FF, the high byte of 0x1300 and the low byte of 0x12FF, while the
+  // interrupt was writing 0x1300
+  uint16_t value = 0x13FF;
+
+  manager.addGroup(0, 4, &value);
+  manager.setSequence(0, &sequence);
+
+  playedSequence = &sequence;
+  playedVariable = &value;
+  playedValue = 0x1300;
+  playedAt = 2;
+  sequenceReads = 0;
+  HostHal::setSequenceListener(&playInterrupt);
+
+  manager.updateAll();
+  CHECK(reads(manager.getFrame(), 4, "4864"));
+  CHECK(sequenceReads == 4);
+
+  // Nothing written: a single read
+  playedAt = 0;
+  sequenceReads = 0;
+  manager.updateAll();
+  CHECK(sequenceReads == 2);
+
+  // Without a Sequence the value is read once, as it is
+  DisplayManager plain(PIN_DATA, PIN_CLOCK, PIN_LATCH, HIGH);
+
+  value = 0x13FF;
+  playedAt = 1;
+  sequenceReads = 0;
+  plain.addGroup(0, 4, &value);
+  plain.updateAll();
+  CHECK(reads(plain.getFrame(), 4, "5119"));
+  CHECK(sequenceReads == 0);
+
+  HostHal::setSequenceListener(NULL);
+}
+
+/**
+ * The brightness is a PWM on the dimming pin only: the updates strobe the latch pin with
+ * plain levels. The pins without PWM, the latch pins and, with the multiplexer, the pins
+ * of Timer2 cannot dim the displays.
+ */
+static void testDimmingPin() {
+  static const byte PIN_DIMMING = 6;
+
+  DisplayManager manager(PIN_DATA, PIN_CLOCK, PIN_LATCH, HIGH);
+  uint16_t value = 42;
+
+  manager.addGroup(0, 2, &value);
+
+  CHECK(!manager.setBrightness(100));
+  CHECK(!manager.setDimmingPin(PIN_LATCH));
+#ifdef digitalPinToTimer
+  CHECK(!manager.setDimmingPin(PIN_DATA));
+#endif
+#ifdef DISPLAYGROUP_MULTIPLEX
+  CHECK(!manager.setDimmingPin(3));
+  CHECK(!manager.setDimmingPin(11));
+#endif
+
+  CHECK(manager.setDimmingPin(PIN_DIMMING));
+  CHECK(HostHal::getLevel(PIN_DIMMING) == LOW);
+  CHECK(manager.setBrightness(100));
+  CHECK(HostHal::getDuty(PIN_DIMMING) == 155);
+
+  manager.forceUpdate();
+
+  CHECK(HostHal::getDuty(PIN_LATCH) == 0);
+  CHECK(HostHal::getDuty(PIN_DIMMING) == 155);
+
+  CHECK(manager.setBrightness(255));
+  CHECK(HostHal::getDuty(PIN_DIMMING) == 0);
+  CHECK(HostHal::getLevel(PIN_DIMMING) == LOW);
+}
+
+/**
+ * The peak memory counts the output buffer only when the library shifts in background,
+ * so it sizes a StaticDisplayManager of the same build.
+ */
+static void testPeakMemory() {
+  DisplayManager manager(PIN_DATA, PIN_CLOCK, PIN_LATCH, HIGH);
+  uint16_t value = 42;
+
+  manager.addGroup(0, 3, &value);
+  manager.addGroup(1, 2, &value);
+
+  uint16_t groups = 2 * (sizeof(DisplayGroup::GroupSlot) + 1) + 2;
+
+#ifdef DISPLAYGROUP_ASYNC
+  CHECK(manager.getPeakMemory() == groups + 2 * 5);
+#else
+  CHECK(manager.getPeakMemory() == groups + 5);
+#endif
+}
+
+int main() {
+#ifndef HOST_AVR
+  testBitBangPins();
+  testBitOrderWire();
+  testStaticCommit();
+  testManagerPins();
+  testBatch();
+  testSetValue();
+  testSetValueFallback();
+  testAnimationForceUpdate();
+  testAnimationDisabled();
+  testShowCodesUnchanged();
+  testAnimationModes();
+  testAnimator();
+#else
+  testBitBangPorts();
+  testParallelPorts();
+  testSpi();
+  testSpiAsync();
+  testCommitWhileBusy();
+  testMultiplexTimer();
+#endif
+
+  testBcd();
+  testRenderChanged();
+  testBitOrderTable();
+  testValueTypes();
+  testFixedPoint();
+  testSymbolsBitOrder();
+  testCounter();
+  testCounterModes();
+  testClockSteps();
+  testClockFormat();
+  testGroupIds();
+  testGroupLimit();
+  testSequence();
+  testDimmingPin();
+  testPeakMemory();
+
+  printf("%u failures\n", failures);
+
+  return failures != 0;
+}
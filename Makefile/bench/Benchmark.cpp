@@ -0,0 +1,254 @@
+/*
+ *  This file is part of DisplayGroup Library.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Benchmark firmware for the atmega328p, run by the cycle accurate simulator (simavr)
+ * with make bench in the Makefile folder.
+ *
+ * The CPU cycles are counted by Timer1, at the CPU clock, and the overflows by its
+ * interrupt. Every result is printed on the UART as a comma separated record:
+ *
+ *   bench,<chain>,<benchmark>,<cycles per operation>
+ *
+ * where chain is groups x displays per group. The firmware stops the simulation by
+ * sleeping with the interrupts disabled.
+ */
+
+#include <Arduino.h>
+#include <avr/sleep.h>
+
+#include <DisplayGroup.h>
+#include <DisplayManager.h>
+
+using DisplayGroup::DisplayManager;
+
+static const byte FRAMES = 16;          /**< Operations measured for each benchmark */
+static const byte MAX_GROUPS = 20;      /**< Groups of the widest configuration */
+
+/**
+ * @brief Chain configuration: number of groups and displays in each group.
+ */
+struct Chain {
+  byte groups;
+  byte displays;
+};
+
+static const Chain CHAINS[] = { { 1, 4 }, { 6, 3 }, { 20, 2 } };
+
+static uint16_t values[MAX_GROUPS];     /**< Watched values */
+
+static volatile uint16_t overflows;     /**< Timer1 overflows since startTimer */
+static uint32_t overhead;               /**< Cycles of startTimer and stopTimer */
+
+ISR(TIMER1_OVF_vect) {
+  ++overflows;
+}
+
+static void startTimer() {
+  TCCR1A = 0;
+  TCCR1B = 0;
+  TCNT1 = 0;
+  overflows = 0;
+  TIFR1 = _BV(TOV1);
+  TIMSK1 = _BV(TOIE1);
+
+  // No prescaler: one count per CPU cycle
+  TCCR1B = _BV(CS10);
+}
+
+static uint32_t stopTimer() {
+  TCCR1B = 0;
+  uint16_t count = TCNT1;
+
+  // Overflow not served yet
+  if (TIFR1 & _BV(TOV1)) {
+    ++overflows;
+    TIFR1 = _BV(TOV1);
+  }
+
+  TIMSK1 = 0;
+
+  return ((uint32_t) overflows << 16 | count) - overhead;
+}
+
+static void uartBegin() {
+  // 115200 baud with double speed at 16 MHz
+  UCSR0A = _BV(U2X0);
+  UBRR0 = 16;
+  UCSR0B = _BV(TXEN0);
+  UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);
+}
+
+static void uartWrite(char c) {
+  while (!(UCSR0A & _BV(UDRE0)))
+    ;
+
+  // Clear the transmit complete flag, set again after this character
+  UCSR0A = _BV(U2X0) | _BV(TXC0);
+  UDR0 = c;
+}
+
+static void uartPrint(const char * str) {
+  while (*str) {
+    uartWrite(*str++);
+  }
+}
+
+static void uartPrint(uint32_t value) {
+  char buf[11];
+  ultoa(value, buf, 10);
+  uartPrint(buf);
+}
+
+/**
+ * Print the record of a benchmark.
+ */
+static void report(const Chain & chain, const char * name, uint32_t cycles) {
+  uartPrint("bench,");
+  uartPrint(chain.groups);
+  uartWrite('x');
+  uartPrint(chain.displays);
+  uartWrite(',');
+  uartPrint(name);
+  uartWrite(',');
+  uartPrint(cycles);
+  uartWrite('\n');
+}
+
+static void fill(DisplayManager & manager, const Chain & chain) {
+  for (byte i = 0; i < chain.groups; ++i) {
+    values[i] = 0;
+    manager.addGroup(i, chain.displays, &values[i]);
+  }
+}
+
+static void changeAll(const Chain & chain) {
+  for (byte i = 0; i < chain.groups; ++i) {
+    values[i] = values[i] < 9 ? values[i] + 1 : 0;
+  }
+}
+
+/**
+ * DisplayManager::updateAll: all the values changed, only the first one changed, nothing
+ * changed, and DisplayManager::forceUpdate.
+ */
+static void benchManager(DisplayManager & manager, const Chain & chain, const char * prefix) {
+  char name[32];
+  uint32_t cycles = 0;
+
+  fill(manager, chain);
+  manager.updateAll();
+
+  for (byte f = 0; f < FRAMES; ++f) {
+    changeAll(chain);
+
+    startTimer();
+    manager.updateAll();
+    cycles += stopTimer();
+  }
+
+  strcpy(name, prefix);
+  report(chain, strcat(name, "updateAll"), cycles / FRAMES);
+
+  cycles = 0;
+
+  for (byte f = 0; f < FRAMES; ++f) {
+    values[0] = values[0] < 9 ? values[0] + 1 : 0;
+
+    startTimer();
+    manager.updateAll();
+    cycles += stopTimer();
+  }
+
+  strcpy(name, prefix);
+  report(chain, strcat(name, "updateAll_one"), cycles / FRAMES);
+
+  startTimer();
+  manager.updateAll();
+  cycles = stopTimer();
+
+  strcpy(name, prefix);
+  report(chain, strcat(name, "updateAll_idle"), cycles);
+
+  startTimer();
+  manager.forceUpdate();
+  cycles = stopTimer();
+
+  strcpy(name, prefix);
+  report(chain, strcat(name, "forceUpdate"), cycles);
+
+  manager.clearGroups();
+}
+
+/**
+ * DisplayGroup::render of one group of the chain, with a changing value.
+ */
+static void benchGroup(const Chain & chain) {
+  byte frame[8];
+  uint16_t value = 0;
+  uint32_t cycles = 0;
+
+  DisplayGroup::DisplayGroup group(chain.displays, 0, &value, DisplayManager::DEF_DIGITS);
+
+  for (byte f = 0; f < FRAMES; ++f) {
+    value += 7;
+
+    startTimer();
+    group.render(frame);
+    cycles += stopTimer();
+  }
+
+  report(chain, "DisplayGroup::render", cycles / FRAMES);
+}
+
+int main() {
+  uartBegin();
+  sei();
+
+  // Calibration of the timer calls
+  overhead = 0;
+  startTimer();
+  overhead = stopTimer();
+
+  for (byte i = 0; i < sizeof(CHAINS) / sizeof(CHAINS[0]); ++i) {
+    {
+      DisplayManager manager(PIN_COM_DATA, PIN_COM_CLOCK, PIN_OUTPUT_ENABLE, HIGH);
+      benchManager(manager, CHAINS[i], "");
+    }
+
+#ifdef DISPLAYGROUP_SPI
+    {
+      DisplayGroup::SpiTransport spi;
+      DisplayManager manager(spi, PIN_OUTPUT_ENABLE, HIGH);
+      benchManager(manager, CHAINS[i], "spi_");
+    }
+#endif
+
+    benchGroup(CHAINS[i]);
+  }
+
+  // Wait for the last character, then stop the simulator
+  while (!(UCSR0A & _BV(TXC0)))
+    ;
+
+  cli();
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  sleep_enable();
+  sleep_cpu();
+
+  return 0;
+}
@@ -0,0 +1,62 @@
+#
+#  This file is part of DisplayGroup Library.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Compare the benchmark results with the baseline:
+#
+#   awk -F, -v tolerance=<percent> -f compare.awk baseline.csv benchmark.csv
+#
+# Each record is bench,<chain>,<benchmark>,<value>, the value is in CPU cycles or in
+# bytes for the size records. The exit status is 1 if any value is greater than its
+# baseline plus the tolerance, if the baseline has no record, or if a baseline record
+# is missing from the results. Records missing from the baseline are only reported.
+
+FNR == NR {
+  if ($1 == "bench") {
+    baseline[$2 "," $3] = $4
+    ++records
+  }
+  next
+}
+
+$1 == "bench" {
+  key = $2 "," $3
+  measured[key] = 1
+
+  if (!(key in baseline)) {
+    printf "NEW        %-32s %10d\n", key, $4
+  } else if ($4 > baseline[key] * (1 + tolerance / 100)) {
+    printf "REGRESSION %-32s %10d (baseline %d)\n", key, $4, baseline[key]
+    failed = 1
+  } else {
+    printf "OK         %-32s %10d (baseline %d)\n", key, $4, baseline[key]
+  }
+}
+
+END {
+  if (records == 0) {
+    print "EMPTY      no record in the baseline, run make bench-baseline"
+    failed = 1
+  }
+
+  for (key in baseline) {
+    if (!(key in measured)) {
+      printf "MISSING    %-32s            (baseline %d)\n", key, baseline[key]
+      failed = 1
+    }
+  }
+
+  exit failed
+}
@@ -0,0 +1,524 @@
+/*
+ *  This file is part of DisplayGroup Library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ */
+
+#include "ShiftTransport.h"
+
+namespace DisplayGroup {
+
+ShiftTransport::~ShiftTransport() {
+}
+
+boolean ShiftTransport::writeAsync(const byte *, uint16_t, void (*)(void *), void *) {
+  return false;
+}
+
+boolean ShiftTransport::isBusy() const {
+  return false;
+}
+
+byte ShiftTransport::getLanes() const {
+  return 1;
+}
+
+void ShiftTransport::writeLanes(const byte values[]) {
+  write(values[0]);
+}
+
+BitBangTransport::BitBangTransport(byte dataP, byte clockP) :
+      _dataPin(dataP), _clockPin(clockP) {
+
+  _dataPort = NULL;
+  _clockPort = NULL;
+  _dataMask = 0;
+  _clockMask = 0;
+}
+
+BitBangTransport::~BitBangTransport() {
+}
+
+void BitBangTransport::begin() {
+  pinMode(_dataPin, OUTPUT);
+  pinMode(_clockPin, OUTPUT);
+
+  // digitalWrite also turns off any PWM timer connected to the pins
+  digitalWrite(_dataPin, LOW);
+  digitalWrite(_clockPin, LOW);
+
+  _dataPort = NULL;
+  _clockPort = NULL;
+
+#ifdef DISPLAYGROUP_PORT_IO
+  // Resolve the pins to port register and bit mask only once
+  byte dataPortId = digitalPinToPort(_dataPin);
+  byte clockPortId = digitalPinToPort(_clockPin);
+
+  if (dataPortId != NOT_A_PIN && clockPortId != NOT_A_PIN) {
+    _dataPort = portOutputRegister(dataPortId);
+    _dataMask = digitalPinToBitMask(_dataPin);
+    _clockPort = portOutputRegister(clockPortId);
+    _clockMask = digitalPinToBitMask(_clockPin);
+  }
+#endif
+}
+
+void BitBangTransport::write(byte value) {
+#ifdef DISPLAYGROUP_PORT_IO
+  if (_dataPort != NULL) {
+    PortRegister * dataPort = _dataPort;
+    PortRegister * clockPort = _clockPort;
+    byte dataMask = _dataMask;
+    byte clockMask = _clockMask;
+
+    // Same protection digitalWrite gives to the read-modify-write on the ports,
+    // but once per byte instead of once per pin transition
+    byte oldSREG = SREG;
+    cli();
+
+    for (byte bitMask = 128; bitMask > 0; bitMask >>= 1) {
+      *clockPort &= ~clockMask;
+
+      if (value & bitMask) {
+        *dataPort |= dataMask;
+      } else {
+        *dataPort &= ~dataMask;
+      }
+
+      *clockPort |= clockMask;
+    }
+
+    SREG = oldSREG;
+    return;
+  }
+#endif
+
+  for (byte bitMask = 128; bitMask > 0; bitMask >>= 1) {
+    digitalWrite(_clockPin, LOW);
+    digitalWrite(_dataPin, value & bitMask ? HIGH : LOW);
+    digitalWrite(_clockPin, HIGH);
+  }
+}
+
+void BitBangTransport::flush() {
+  // The bits are shifted synchronously in BitBangTransport::write
+}
+
+ParallelTransport::ParallelTransport(const byte dataPins[], byte lanes, byte clockP) :
+      _lanes(lanes < MAX_LANES ? lanes : MAX_LANES), _clockPin(clockP) {
+
+  for (byte k = 0; k < _lanes; ++k) {
+    _dataPins[k] = dataPins[k];
+    _dataMasks[k] = 0;
+  }
+
+  _dataPort = NULL;
+  _clockPort = NULL;
+  _dataMask = 0;
+  _clockMask = 0;
+}
+
+ParallelTransport::~ParallelTransport() {
+}
+
+void ParallelTransport::begin() {
+  pinMode(_clockPin, OUTPUT);
+  digitalWrite(_clockPin, LOW);
+
+  for (byte k = 0; k < _lanes; ++k) {
+    pinMode(_dataPins[k], OUTPUT);
+    digitalWrite(_dataPins[k], LOW);
+  }
+
+  _dataPort = NULL;
+  _clockPort = NULL;
+
+#ifdef DISPLAYGROUP_PORT_IO
+  // All the data pins must share one output register
+  byte dataPortId = digitalPinToPort(_dataPins[0]);
+  byte clockPortId = digitalPinToPort(_clockPin);
+  boolean samePort = dataPortId != NOT_A_PIN && clockPortId != NOT_A_PIN;
+
+  _dataMask = 0;
+
+  for (byte k = 0; k < _lanes && samePort; ++k) {
+    samePort = digitalPinToPort(_dataPins[k]) == dataPortId;
+    _dataMasks[k] = digitalPinToBitMask(_dataPins[k]);
+    _dataMask |= _dataMasks[k];
+  }
+
+  if (samePort) {
+    _dataPort = portOutputRegister(dataPortId);
+    _clockPort = portOutputRegister(clockPortId);
+    _clockMask = digitalPinToBitMask(_clockPin);
+  }
+#endif
+}
+
+void ParallelTransport::write(byte value) {
+  byte values[MAX_LANES] = { value };
+
+  writeLanes(values);
+}
+
+void ParallelTransport::writeLanes(const byte values[]) {
+#ifdef DISPLAYGROUP_PORT_IO
+  if (_dataPort != NULL) {
+    PortRegister * dataPort = _dataPort;
+    PortRegister * clockPort = _clockPort;
+    byte keep = ~_dataMask;
+    byte clockMask = _clockMask;
+
+    byte oldSREG = SREG;
+    cli();
+
+    for (byte bitMask = 128; bitMask > 0; bitMask >>= 1) {
+      // The next bit of every chain in one port byte
+      byte out = 0;
+
+      for (byte k = 0; k < _lanes; ++k) {
+        if (values[k] & bitMask) {
+          out |= _dataMasks[k];
+        }
+      }
+
+      *clockPort &= ~clockMask;
+      *dataPort = (*dataPort & keep) | out;
+      *clockPort |= clockMask;
+    }
+
+    SREG = oldSREG;
+    return;
+  }
+#endif
+
+  for (byte bitMask = 128; bitMask > 0; bitMask >>= 1) {
+    digitalWrite(_clockPin, LOW);
+
+    for (byte k = 0; k < _lanes; ++k) {
+      digitalWrite(_dataPins[k], values[k] & bitMask ? HIGH : LOW);
+    }
+
+    digitalWrite(_clockPin, HIGH);
+  }
+}
+
+void ParallelTransport::flush() {
+  // The bits are shifted synchronously in ParallelTransport::writeLanes
+}
+
+byte ParallelTransport::getLanes() const {
+  return _lanes;
+}
+
+MultiplexTransport::MultiplexTransport(ShiftTransport & segments, byte latchP, const byte digitPins[], byte digits, byte digitOnState) :
+      _segments(segments), _latchPin(latchP), _digits(digits < MAX_DIGITS ? digits : MAX_DIGITS),
+      _digitOnState(digitOnState) {
+
+  for (byte k = 0; k < _digits; ++k) {
+    _digitPins[k] = digitPins[k];
+    _digitPorts[k] = NULL;
+    _digitMasks[k] = 0;
+    _buffers[0][k] = 0;
+    _buffers[1][k] = 0;
+  }
+
+  _front = 0;
+  _written = 0;
+  _digit = 0;
+  _latchPort = NULL;
+  _latchMask = 0;
+}
+
+MultiplexTransport::~MultiplexTransport() {
+}
+
+void MultiplexTransport::begin() {
+  pinMode(_latchPin, OUTPUT);
+  digitalWrite(_latchPin, LOW);
+
+  for (byte k = 0; k < _digits; ++k) {
+    pinMode(_digitPins[k], OUTPUT);
+    digitalWrite(_digitPins[k], !_digitOnState);
+  }
+
+  _segments.begin();
+
+#ifdef DISPLAYGROUP_PORT_IO
+  // Resolve the pins to port register and bit mask only once, the refresh only writes
+  // the registers
+  boolean resolved = digitalPinToPort(_latchPin) != NOT_A_PIN;
+
+  for (byte k = 0; k < _digits; ++k) {
+    resolved = resolved && digitalPinToPort(_digitPins[k]) != NOT_A_PIN;
+  }
+
+  if (resolved) {
+    _latchPort = portOutputRegister(digitalPinToPort(_latchPin));
+    _latchMask = digitalPinToBitMask(_latchPin);
+
+    for (byte k = 0; k < _digits; ++k) {
+      _digitPorts[k] = portOutputRegister(digitalPinToPort(_digitPins[k]));
+      _digitMasks[k] = digitalPinToBitMask(_digitPins[k]);
+    }
+  }
+#endif
+}
+
+void MultiplexTransport::write(byte value) {
+  if (_written < _digits) {
+    _buffers[_front ^ 1][_written++] = value;
+  }
+}
+
+void MultiplexTransport::flush() {
+  byte * back = _buffers[_front ^ 1];
+
+  for (; _written < _digits; ++_written) {
+    back[_written] = 0;
+  }
+
+  // A single byte store: the refresh reads either the whole old or the whole new frame
+  _front ^= 1;
+  _written = 0;
+}
+
+void MultiplexTransport::refresh() {
+  if (_digits == 0) {
+    return;
+  }
+
+#ifdef DISPLAYGROUP_PORT_IO
+  // The ports may be shared with pins written by the interrupts
+  byte oldSREG = SREG;
+  cli();
+#endif
+
+  byte digit = _digit;
+
+  // The display shown is turned off while the segments change, to avoid ghosting
+  select(digit, false);
+
+  if (++digit == _digits) {
+    digit = 0;
+  }
+
+  _segments.write(_buffers[_front][digit]);
+  _segments.flush();
+
+#ifdef DISPLAYGROUP_PORT_IO
+  if (_latchPort != NULL) {
+    *_latchPort |= _latchMask;
+    *_latchPort &= ~_latchMask;
+  } else
+#endif
+  {
+    digitalWrite(_latchPin, HIGH);
+    digitalWrite(_latchPin, LOW);
+  }
+
+  select(digit, true);
+  _digit = digit;
+
+#ifdef DISPLAYGROUP_PORT_IO
+  SREG = oldSREG;
+#endif
+}
+
+void MultiplexTransport::select(byte digit, boolean on) {
+  byte level = on ? _digitOnState : !_digitOnState;
+
+#ifdef DISPLAYGROUP_PORT_IO
+  if (_digitPorts[digit] != NULL) {
+    if (level == HIGH) {
+      *_digitPorts[digit] |= _digitMasks[digit];
+    } else {
+      *_digitPorts[digit] &= ~_digitMasks[digit];
+    }
+
+    return;
+  }
+#endif
+
+  digitalWrite(_digitPins[digit], level);
+}
+
+byte MultiplexTransport::getDigits() const {
+  return _digits;
+}
+
+#ifdef DISPLAYGROUP_MULTIPLEX
+
+MultiplexTransport * volatile MultiplexTransport::_timerTransport = NULL;
+
+boolean MultiplexTransport::startTimer(MultiplexTransport & transport, uint16_t frameRate) {
+  static const uint16_t PRESCALERS[] = { 1, 8, 32, 64, 128, 256, 1024 };
+  uint32_t rate = (uint32_t) frameRate * transport._digits;
+
+  if (rate == 0) {
+    return false;
+  }
+
+  for (byte k = 0; k < sizeof(PRESCALERS) / sizeof(PRESCALERS[0]); ++k) {
+    uint32_t top = F_CPU / ((uint32_t) PRESCALERS[k] * rate);
+
+    if (top >= 1 && top <= 256) {
+      stopTimer();
+
+      _timerTransport = &transport;
+
+      // CTC mode: the counter restarts at OCR2A, the clock select is the prescaler index
+      TCCR2A = _BV(WGM21);
+      TCCR2B = k + 1;
+      TCNT2 = 0;
+      OCR2A = top - 1;
+      TIFR2 = _BV(OCF2A);
+      TIMSK2 = _BV(OCIE2A);
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void MultiplexTransport::stopTimer() {
+  TIMSK2 = 0;
+  TCCR2B = 0;
+
+  MultiplexTransport * transport = _timerTransport;
+  _timerTransport = NULL;
+
+  if (transport != NULL && transport->_digits != 0) {
+    transport->select(transport->_digit, false);
+  }
+}
+
+void MultiplexTransport::onTimer() {
+  MultiplexTransport * transport = _timerTransport;
+
+  if (transport != NULL) {
+    transport->refresh();
+  }
+}
+
+#endif
+
+#ifdef DISPLAYGROUP_SPI
+
+#ifdef DISPLAYGROUP_ASYNC
+const byte * volatile SpiTransport::_asyncData = NULL;
+const byte * volatile SpiTransport::_asyncEnd = NULL;
+void (* volatile SpiTransport::_asyncCallback)(void *) = NULL;
+void * volatile SpiTransport::_asyncContext = NULL;
+#endif
+
+SpiTransport::SpiTransport() {
+  _pending = false;
+}
+
+SpiTransport::~SpiTransport() {
+}
+
+void SpiTransport::begin() {
+  // SS must be an output to keep the peripheral in master mode
+  pinMode(SS, OUTPUT);
+  pinMode(MOSI, OUTPUT);
+  pinMode(SCK, OUTPUT);
+  digitalWrite(SCK, LOW);
+
+  // Master, mode 0 (sample on the rising edge, as the 74HC595 does), MSB first, F_CPU/2
+  SPCR = _BV(SPE) | _BV(MSTR);
+  SPSR = _BV(SPI2X);
+
+  _pending = false;
+}
+
+void SpiTransport::write(byte value) {
+  if (_pending) {
+    while (!(SPSR & _BV(SPIF)))
+      ;
+  }
+
+  // Reading SPSR with SPIF set and then writing SPDR clears the flag
+  SPDR = value;
+  _pending = true;
+}
+
+void SpiTransport::flush() {
+  if (_pending) {
+    while (!(SPSR & _BV(SPIF)))
+      ;
+
+    // Clear SPIF
+    (void) SPDR;
+    _pending = false;
+  }
+}
+
+#ifdef DISPLAYGROUP_ASYNC
+
+boolean SpiTransport::writeAsync(const byte * data, uint16_t size, void (*callback)(void *), void * context) {
+  // The interrupt would clear SPIF under the polling loop
+  flush();
+
+  _asyncData = data + 1;
+  _asyncEnd = data + size;
+  _asyncCallback = callback;
+  _asyncContext = context;
+
+  SPCR |= _BV(SPIE);
+  SPDR = *data;
+
+  return true;
+}
+
+boolean SpiTransport::isBusy() const {
+  return (SPCR & _BV(SPIE)) != 0;
+}
+
+void SpiTransport::onTransferComplete() {
+  const byte * data = _asyncData;
+
+  if (data != _asyncEnd) {
+    SPDR = *data;
+    _asyncData = data + 1;
+  } else {
+    SPCR &= ~_BV(SPIE);
+    _asyncCallback(_asyncContext);
+  }
+}
+
+#endif
+
+#endif
+
+} /* namespace DisplayGroup */
+
+#ifdef DISPLAYGROUP_ASYNC
+
+ISR(SPI_STC_vect) {
+  DisplayGroup::SpiTransport::onTransferComplete();
+}
+
+#endif
+
+#ifdef DISPLAYGROUP_MULTIPLEX
+
+ISR(TIMER2_COMPA_vect) {
+  DisplayGroup::MultiplexTransport::onTimer();
+}
+
+#endif
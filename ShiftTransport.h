@@ -0,0 +1,396 @@
+/*
+ *  This file is part of DisplayGroup Library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ */
+
+#ifndef SHIFTTRANSPORT_H_
+#define SHIFTTRANSPORT_H_
+
+// The core headers first: the features below are detected from their macros
+#include <Arduino.h>
+
+// Direct port register output, available when the core exposes the pin to port mapping.
+// Define DISPLAYGROUP_NO_PORT_IO to force the portable digitalWrite path.
+#if defined(portOutputRegister) && !defined(DISPLAYGROUP_NO_PORT_IO)
+#define DISPLAYGROUP_PORT_IO
+#endif
+
+// Type of an output register, see portOutputRegister. A core that models its registers
+// as objects, as the host simulation does, defines it before the library headers.
+#ifndef DISPLAYGROUP_PORT_REGISTER
+#define DISPLAYGROUP_PORT_REGISTER volatile uint8_t
+#endif
+
+// Hardware SPI transport, available on AVR CPUs with the SPI peripheral
+#if defined(SPDR)
+#define DISPLAYGROUP_SPI
+#endif
+
+// Background shift of whole frames by the SPI transfer complete interrupt.
+// Define DISPLAYGROUP_ASYNC to let the library own the SPI_STC_vect interrupt.
+#if defined(DISPLAYGROUP_ASYNC) && !defined(DISPLAYGROUP_SPI)
+#undef DISPLAYGROUP_ASYNC
+#endif
+
+// Multiplexed refresh driven by the Timer2 compare match interrupt.
+// Define DISPLAYGROUP_MULTIPLEX to let the library own the TIMER2_COMPA_vect interrupt.
+#if defined(DISPLAYGROUP_MULTIPLEX) && !defined(TCCR2A)
+#undef DISPLAYGROUP_MULTIPLEX
+#endif
+
+namespace DisplayGroup {
+
+typedef DISPLAYGROUP_PORT_REGISTER PortRegister;   /**< Output register of a port */
+
+/**
+ * @brief Interface for the link that carries the bytes to the shift register chain.
+ *
+ * A transport clocks bytes, most significant bit first, into the chain of 74HC595
+ * (or 74HC164) shift registers. The latch or output enable pin is not part of the
+ * transport: it is driven by the DisplayManager around a whole chain update.
+ *
+ * ShiftTransport::write may return before the byte has been completely shifted out,
+ * so the caller can prepare the next byte while the hardware is busy.
+ * ShiftTransport::flush waits until the last byte has left the transport.
+ * A transport may also shift out a whole buffer in background, see
+ * ShiftTransport::writeAsync, or drive several chains at once, one bit of each chain at
+ * every clock, see ShiftTransport::writeLanes.
+ *
+ * @date   Oct 17, 2026
+ */
+class ShiftTransport {
+public:
+
+  static const byte MAX_LANES = 8;  /**< Maximum number of chains shifted at once */
+
+  /** Default destructor.
+   */
+  virtual ~ShiftTransport();
+
+  /**
+   * Configure the pins and the peripheral used by the transport.
+   */
+  virtual void begin() = 0;
+
+  /**
+   * Start shifting out one byte, most significant bit first.
+   *
+   * @param[in] value       The byte to shift out
+   */
+  virtual void write(byte value) = 0;
+
+  /**
+   * Wait until the last byte written has been completely shifted out.
+   */
+  virtual void flush() = 0;
+
+  /**
+   * Start shifting out a buffer in background and return immediately. The buffer must
+   * not be modified until the callback has been called, from interrupt context, after
+   * the last byte has been completely shifted out.
+   * The default implementation does not support background transfers.
+   *
+   * @param[in] data        The bytes to shift out, most significant bit first
+   * @param[in] size        Number of bytes, greater than zero
+   * @param[in] callback    Function called from the interrupt at the end of the transfer
+   * @param[in] context     Argument of the callback
+   * @return True if the transfer has been started, false if the transport cannot shift
+   *         out in background: nothing has been sent in that case
+   */
+  virtual boolean writeAsync(const byte * data, uint16_t size, void (*callback)(void *), void * context);
+
+  /**
+   * @return True while a background transfer started by ShiftTransport::writeAsync is in
+   *         progress: nothing else can be written until it ends. False by default.
+   */
+  virtual boolean isBusy() const;
+
+  /**
+   * @return The number of chains driven at once by the transport, 1 by default.
+   */
+  virtual byte getLanes() const;
+
+  /**
+   * Shift out one byte on every chain at once, most significant bit first. The default
+   * implementation has a single lane and writes values[0].
+   *
+   * @param[in] values      One byte for each lane, see ShiftTransport::getLanes
+   */
+  virtual void writeLanes(const byte values[]);
+};
+
+/**
+ * @brief Software transport: the data and clock pins are toggled by the CPU.
+ *
+ * When the data and clock pins can be resolved to port registers in BitBangTransport::begin
+ * the bits are toggled with direct register writes, otherwise with digitalWrite. Any pair
+ * of digital pins can be used.
+ */
+class BitBangTransport: public ShiftTransport {
+public:
+
+  /**
+   * Constructor.
+   *
+   * @param[in] dataP       Arduino data pin for shift register
+   * @param[in] clockP      Arduino clock pin for shift register
+   */
+  BitBangTransport(byte dataP, byte clockP);
+
+  /** Default destructor.
+   */
+  virtual ~BitBangTransport();
+
+  virtual void begin();
+  virtual void write(byte value);
+  virtual void flush();
+
+private:
+  byte _dataPin;                    /**< Arduino data pin */
+  byte _clockPin;                   /**< Arduino clock pin */
+
+  PortRegister * _dataPort;         /**< Output register of the data pin, NULL if not resolved */
+  PortRegister * _clockPort;        /**< Output register of the clock pin, NULL if not resolved */
+  byte _dataMask;                   /**< Bit mask of the data pin in its output register */
+  byte _clockMask;                  /**< Bit mask of the clock pin in its output register */
+};
+
+/**
+ * @brief Bit-parallel software transport: up to 8 chains share the clock pin, each chain
+ * has its own data pin.
+ *
+ * When all the data pins are on the same port, resolved in ParallelTransport::begin, every
+ * clock carries the next bit of all the chains with a single write of the port register:
+ * 8 chains are refreshed in the time a single chain takes with BitBangTransport. The other
+ * pins of the port are not changed. Otherwise the pins are toggled with digitalWrite.
+ * ParallelTransport::write shifts the byte on the first chain and zeros on the others.
+ */
+class ParallelTransport: public ShiftTransport {
+public:
+
+  /**
+   * Constructor.
+   *
+   * @param[in] dataPins    Arduino data pin of each chain, copied
+   * @param[in] lanes       Number of chains, at most ShiftTransport::MAX_LANES
+   * @param[in] clockP      Arduino clock pin shared by all the chains
+   */
+  ParallelTransport(const byte dataPins[], byte lanes, byte clockP);
+
+  /** Default destructor.
+   */
+  virtual ~ParallelTransport();
+
+  virtual void begin();
+  virtual void write(byte value);
+  virtual void flush();
+  virtual byte getLanes() const;
+  virtual void writeLanes(const byte values[]);
+
+private:
+  byte _dataPins[MAX_LANES];        /**< Arduino data pin of each chain */
+  byte _lanes;                      /**< Number of chains */
+  byte _clockPin;                   /**< Arduino clock pin */
+
+  PortRegister * _dataPort;         /**< Output register of all the data pins, NULL if not resolved */
+  PortRegister * _clockPort;        /**< Output register of the clock pin */
+  byte _dataMasks[MAX_LANES];       /**< Bit mask of each data pin in the data register */
+  byte _dataMask;                   /**< Bit mask of all the data pins */
+  byte _clockMask;                  /**< Bit mask of the clock pin in its output register */
+};
+
+/**
+ * @brief Multiplexed direct drive: one segment register shared by all the displays, each
+ * display selected by its own common cathode (or anode) pin.
+ *
+ * The bytes written by the DisplayManager do not go to a chain: they are stored, one for
+ * each display, in the back buffer, which becomes the front buffer at
+ * MultiplexTransport::flush. MultiplexTransport::refresh turns off the display shown,
+ * shifts the code of the next display into the segment register through its own
+ * transport, latches it and turns on the next display: only one display is lit at a time,
+ * so the refresh must run at a steady rate, from a timer interrupt
+ * (MultiplexTransport::startTimer) or from the loop.
+ * The refresh does no arithmetic: it reads one byte of the front buffer, and when the
+ * pins can be resolved to port registers the select and latch pins are single register
+ * writes. The segment transport must not be shared, and the chain must not be split in
+ * segments (DisplayManager::setSegmentPin): each frame is written whole.
+ * The output enable pin of the DisplayManager is not needed by the displays, any unused
+ * pin can be given.
+ */
+class MultiplexTransport: public ShiftTransport {
+public:
+
+  static const byte MAX_DIGITS = 16;  /**< Maximum number of displays */
+
+  /**
+   * Constructor.
+   *
+   * @param[in] segments    Transport of the segment register, e.g. a BitBangTransport
+   * @param[in] latchP      Arduino latch pin of the segment register, pulsed high after
+   *                        each display code
+   * @param[in] digitPins   Arduino select pin of each display, copied: digitPins[i] selects
+   *                        the display of the i-th byte of the frame, see
+   *                        DisplayManager::getFrame
+   * @param[in] digits      Number of displays, at most MultiplexTransport::MAX_DIGITS
+   * @param[in] digitOnState Logical state (HIGH or LOW) of a select pin that turns its
+   *                        display on
+   */
+  MultiplexTransport(ShiftTransport & segments, byte latchP, const byte digitPins[], byte digits, byte digitOnState);
+
+  /** Default destructor.
+   */
+  virtual ~MultiplexTransport();
+
+  virtual void begin();
+
+  /**
+   * Store the code of the next display in the back buffer. The bytes beyond the number of
+   * displays are ignored.
+   */
+  virtual void write(byte value);
+
+  /**
+   * Show the back buffer: it becomes the front buffer, read by the next refresh. The
+   * displays not written since the last flush are blank.
+   */
+  virtual void flush();
+
+  /**
+   * Show the next display: called at a steady rate, the number of displays times the frame
+   * rate, usually by the timer interrupt.
+   */
+  void refresh();
+
+  /**
+   * @return The number of displays.
+   */
+  byte getDigits() const;
+
+#ifdef DISPLAYGROUP_MULTIPLEX
+  /**
+   * Refresh the transport from the Timer2 compare match interrupt. The timer is
+   * configured in CTC mode with the smallest prescaler that fits the rate, so the
+   * interrupt only calls MultiplexTransport::refresh. Timer2 is also used by tone() and by
+   * the PWM of its pins, which cannot be used any more.
+   *
+   * @param[in] transport   The transport to refresh, it must outlive the timer
+   * @param[in] frameRate   Frames per second: the interrupt runs frameRate times the number
+   *                        of displays each second
+   * @return True on success, false if the rate cannot be reached by the timer
+   */
+  static boolean startTimer(MultiplexTransport & transport, uint16_t frameRate);
+
+  /**
+   * Stop the timer interrupt and turn off the displays.
+   */
+  static void stopTimer();
+
+  /**
+   * Refresh the transport given to MultiplexTransport::startTimer, called by the interrupt.
+   */
+  static void onTimer();
+#endif
+
+private:
+
+  /**
+   * Turn a display on or off.
+   * @param[in] digit       The display
+   * @param[in] on          True to turn it on
+   */
+  void select(byte digit, boolean on);
+
+  ShiftTransport & _segments;       /**< Transport of the segment register */
+  byte _latchPin;                   /**< Arduino latch pin of the segment register */
+  byte _digitPins[MAX_DIGITS];      /**< Arduino select pin of each display */
+  byte _digits;                     /**< Number of displays */
+  byte _digitOnState;               /**< Logical state of a select pin that turns its display on */
+
+  byte _buffers[2][MAX_DIGITS];     /**< Front and back buffers, one code for each display */
+  volatile byte _front;             /**< Index of the front buffer, read by the refresh */
+  byte _written;                    /**< Number of codes written in the back buffer */
+  byte _digit;                      /**< Display shown */
+
+  PortRegister * _latchPort;        /**< Output register of the latch pin, NULL if not resolved */
+  byte _latchMask;                  /**< Bit mask of the latch pin in its output register */
+  PortRegister * _digitPorts[MAX_DIGITS]; /**< Output register of each select pin, NULL if not resolved */
+  byte _digitMasks[MAX_DIGITS];     /**< Bit mask of each select pin in its output register */
+
+#ifdef DISPLAYGROUP_MULTIPLEX
+  static MultiplexTransport * volatile _timerTransport; /**< Transport refreshed by the timer */
+#endif
+};
+
+#ifdef DISPLAYGROUP_SPI
+
+/**
+ * @brief Hardware SPI transport: the SPI peripheral shifts the bytes at F_CPU/2.
+ *
+ * The data line of the chain must be connected to the MOSI pin and the clock line to
+ * the SCK pin. The SS pin is configured as output, as required by the master mode,
+ * and it cannot be used as input by the application.
+ * Each byte is a single write of the SPI data register: SpiTransport::write only waits
+ * for the previous byte, so the next byte is prepared while the current one is shifted.
+ */
+class SpiTransport: public ShiftTransport {
+public:
+
+  /**
+   * Default constructor.
+   */
+  SpiTransport();
+
+  /** Default destructor.
+   */
+  virtual ~SpiTransport();
+
+  virtual void begin();
+  virtual void write(byte value);
+  virtual void flush();
+
+#ifdef DISPLAYGROUP_ASYNC
+  /**
+   * Background transfer driven by the SPI transfer complete interrupt: one byte is
+   * written to the SPI data register at each interrupt.
+   */
+  virtual boolean writeAsync(const byte * data, uint16_t size, void (*callback)(void *), void * context);
+
+  /**
+   * @return True while the SPI interrupt is shifting a buffer.
+   */
+  virtual boolean isBusy() const;
+
+  /**
+   * Write the next byte of the background transfer, called by the SPI interrupt.
+   */
+  static void onTransferComplete();
+#endif
+
+private:
+  boolean _pending;                 /**< True when a byte has been written and not waited for */
+
+#ifdef DISPLAYGROUP_ASYNC
+  static const byte * volatile _asyncData;      /**< Next byte of the background transfer */
+  static const byte * volatile _asyncEnd;       /**< End of the background transfer */
+  static void (* volatile _asyncCallback)(void *); /**< Callback at the end of the transfer */
+  static void * volatile _asyncContext;         /**< Argument of the callback */
+#endif
+};
+
+#endif
+
+} /* namespace DisplayGroup */
+
+#endif /* SHIFTTRANSPORT_H_ */
@@ -0,0 +1,98 @@
+/*
+ *  This file is part of DisplayGroup Library.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ */
+
+#ifndef STATICDISPLAYMANAGER_H_
+#define STATICDISPLAYMANAGER_H_
+
+#include <Arduino.h>
+
+#include <DisplayManager.h>
+
+namespace DisplayGroup {
+
+/**
+ * @brief DisplayManager with a capacity fixed at compile time, which never uses the heap.
+ *
+ * All the buffers of the manager are members of this class, so they are allocated
+ * statically (or on the stack) together with the manager: the groups are built in place
+ * in the slots of the pool and the frame buffer has room for DISPLAYS displays, as the
+ * output buffer of the background shift when the library is built with DISPLAYGROUP_ASYNC. Reconfiguring the groups between two periods of a long running application
+ * does not fragment the heap.
+ *
+ * When a configuration does not fit, addGroup, insertGroup and replaceGroup return false
+ * and leave the manager unchanged. DisplayManager::getPeakGroups and
+ * DisplayManager::getPeakDisplays tell how much of the pool has been used.
+ *
+ * @tparam GROUPS       Maximum number of groups, less than 255
+ * @tparam DISPLAYS     Maximum number of displays of all the groups
+ * @tparam IDS          Number of valid group ids, [0, IDS - 1]: the id index takes one byte
+ *                      for each id
+ *
+ * @date   Oct 17, 2026
+ */
+template <byte GROUPS, uint16_t DISPLAYS, uint16_t IDS = GROUPS>
+class StaticDisplayManager: public DisplayManager {
+public:
+
+  /**
+   * Constructor, see DisplayManager::DisplayManager.
+   */
+  StaticDisplayManager(byte dataP, byte clockP, byte outputEnableP, byte outputEnableState) :
+        DisplayManager(dataP, clockP, outputEnableP, outputEnableState) {
+    usePool(pool());
+  }
+
+  /**
+   * Constructor with a user supplied transport, see DisplayManager::DisplayManager.
+   */
+  StaticDisplayManager(ShiftTransport & transport, byte outputEnableP, byte outputEnableState) :
+        DisplayManager(transport, outputEnableP, outputEnableState) {
+    usePool(pool());
+  }
+
+  /** Destructor: the groups are destroyed while their slots are still alive.
+   */
+  virtual ~StaticDisplayManager() {
+    clearGroups();
+  }
+
+private:
+
+  /**
+   * @return The buffers of this manager
+   */
+  GroupPool pool() {
+#ifdef DISPLAYGROUP_ASYNC
+    GroupPool p = { _poolSlots, _poolOrder, GROUPS, _poolIndex, IDS, _poolFrame, _poolFront, DISPLAYS };
+#else
+    GroupPool p = { _poolSlots, _poolOrder, GROUPS, _poolIndex, IDS, _poolFrame, NULL, DISPLAYS };
+#endif
+    return p;
+  }
+
+  GroupSlot _poolSlots[GROUPS];            /**< Storage of the groups */
+  byte _poolOrder[GROUPS];                 /**< Order of the groups */
+  byte _poolIndex[IDS];                    /**< Slot of each group by id */
+  byte _poolFrame[DISPLAYS];               /**< Frame buffer */
+#ifdef DISPLAYGROUP_ASYNC
+  byte _poolFront[DISPLAYS];               /**< Output buffer of the background shift */
+#endif
+};
+
+} /* namespace DisplayGroup */
+
+#endif /* STATICDISPLAYMANAGER_H_ */